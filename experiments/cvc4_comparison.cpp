@@ -21,9 +21,12 @@
  * SOFTWARE.
  */
 
+#include "graphs_generation.hpp"
+
 #include <iomanip>
 #include <sstream>
 
+#include <enumeration_tool/enumerator_engines/partial_dag_enumerator.hpp>
 #include <enumeration_tool/enumerators/aig_enumerator.hpp>
 #include <kitty/kitty.hpp>
 #include <lorina/aiger.hpp>
@@ -59,6 +62,10 @@ auto main() -> int
   mockturtle::default_simulator<kitty::dynamic_truth_table> sim(var_num);
 
   std::vector<int> num_num_formulas(num_formulas);
+  std::vector<percy::partial_dag> generated = generate_dags(1, 4);
+  const auto timeout = std::chrono::seconds(60);
+
+  using enumerator_t = enumeration_tool::partial_dag_enumerator<mockturtle::aig_network, mockturtle::aig_network::signal, EnumerationSymbols>;
 
   try
   {
@@ -76,11 +83,10 @@ auto main() -> int
       solution["dot"] = "";
       solution["aiger"] = "";
 
-      std::function<void(enumeration_tool::partial_dag_enumerator<mockturtle::aig_network, mockturtle::aig_network::signal, EnumerationSymbols>*, const std::shared_ptr<mockturtle::aig_network>&)>
-        use_formula =
-          [&](enumeration_tool::partial_dag_enumerator<mockturtle::aig_network, mockturtle::aig_network::signal, EnumerationSymbols>* enumerator, const std::shared_ptr<mockturtle::aig_network>& ntk) {
+      enumerator_t::callback_t use_formula =
+          [&](enumerator_t* enumerator) {
             num_num_formulas[i]++;
-            mockturtle::aig_network item = *ntk;
+            mockturtle::aig_network item = *(enumerator->to_enumeration_type());
             const auto tt = mockturtle::simulate<kitty::dynamic_truth_table>(item, sim);
             const auto value = kitty::to_hex(tt[0]);
             /* DEBUG */
@@ -97,21 +103,18 @@ auto main() -> int
               solution["solution"] = enumerator->get_current_solution();
               solution["dot"] = enumerator->to_dot();
               solution["aiger"] = aiger_output.str();
-              throw std::runtime_error("Solution found! Stop everything!");
+              enumerator->stop();
             }
           };
 
       auto aig_interface = std::make_shared<aig_enumeration_interface>();
       auto generic_interface = std::static_pointer_cast<enumeration_interface<mockturtle::aig_network, mockturtle::aig_network::signal, EnumerationSymbols>>(aig_interface);
 
-      enumeration_tool::partial_dag_enumerator<mockturtle::aig_network, mockturtle::aig_network::signal, EnumerationSymbols> en(store.build_grammar(), generic_interface, use_formula);
+      enumerator_t en(store.build_grammar(), generic_interface, use_formula);
 
       auto duration = measure<std::chrono::microseconds>::execution_thread([&]() {
-        try {
-          en.enumerate_aig(4);
-        } catch (const std::runtime_error& e) {
-          std::cerr << e.what() << std::endl;
-        }
+        en.limits.set_timeout(timeout);
+        en.enumerate_aig_pre_enumeration(generated);
       });
 
       if (duration == 0) {
@@ -130,11 +133,8 @@ auto main() -> int
           if ( clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) < 0 ) exit(-1);
           std::chrono::nanoseconds start(ts.tv_nsec + (ts.tv_sec * 1000000000));
 
-          try {
-            en.enumerate_aig(4);
-          } catch (const std::runtime_error& e) {
-            std::cerr << e.what() << std::endl;
-          }
+          en.limits.set_timeout(timeout);
+          en.enumerate_aig_pre_enumeration(generated);
 
           if ( clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) < 0 ) exit(-1);
           std::chrono::nanoseconds end(ts.tv_nsec + (ts.tv_sec * 1000000000));
@@ -147,6 +147,9 @@ auto main() -> int
 
       std::cout << "Enumeration time: " << duration << std::endl;
       std::cout << "Num formulas: " << num_num_formulas[i] << std::endl;
+      if (en.status == enumeration_tool::enumeration_status::timeout) {
+        solution["num_formulas"] = num_num_formulas[i];
+      }
       solution["time"] = duration;
       j.emplace_back(solution);
     }
@@ -0,0 +1,78 @@
+/* MIT License
+ *
+ * Copyright (c) 2020 Gianluca Martino
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "graphs_generation.hpp"
+
+#include <enumeration_tool/enumerator_engines/partial_dag_enumerator.hpp>
+#include <enumeration_tool/enumerators/aig_enumerator.hpp>
+#include <mockturtle/io/write_aiger.hpp>
+#include <nlohmann/json.hpp>
+
+#include <fstream>
+#include <sstream>
+
+using enumerator_t = enumeration_tool::partial_dag_enumerator<mockturtle::aig_network, mockturtle::aig_network::signal, EnumerationSymbols>;
+
+// minimum AIG of every 3-input function, with a single enumeration of the DAGs
+auto main() -> int
+{
+  int min_vertices = 1;
+  int max_vertices = 7;
+
+  std::vector<percy::partial_dag> generated = generate_dags(min_vertices, max_vertices);
+
+  aig_enumeration_interface store;
+  enumerator_t en(store.build_grammar(), std::make_shared<aig_enumeration_interface>());
+  en.set_all_targets();
+
+  auto duration = measure<std::chrono::microseconds>::execution_thread([&]() {
+    en.enumerate_aig_pre_enumeration(generated);
+  });
+
+  std::cout << fmt::format("Covered functions: {}", en.target_solutions.size()) << std::endl;
+  std::cout << "Enumeration time: " << duration << std::endl;
+
+  nlohmann::json j;
+  auto solutions = en.target_solutions; // loading a solution changes the state of the enumerator
+  for (const auto& [tt, solution] : solutions) {
+    en.load_target_solution(generated, solution);
+
+    std::stringstream aiger_output;
+    mockturtle::write_aiger(*(en.to_enumeration_type()), aiger_output);
+
+    nlohmann::json item;
+    item["target"] = kitty::to_hex(tt);
+    item["num_gates"] = solution.nr_gates;
+    item["solution"] = en.get_current_solution();
+    item["dot"] = en.to_dot();
+    item["aiger"] = aiger_output.str();
+    j.emplace_back(item);
+  }
+
+  auto t = std::time(nullptr);
+
+  std::ofstream ofs(fmt::format("minimum_circuits_{}.txt", t));
+  ofs << j.dump();
+
+  return 0;
+}
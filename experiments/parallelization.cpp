@@ -67,7 +67,6 @@ auto main() -> int
   nlohmann::json j;
 
   auto tts = generate_tts(var_num, num_formulas);
-  mockturtle::default_simulator<kitty::dynamic_truth_table> sim(var_num);
 
   int min_vertices = 1;
   int max_vertices = 6;
@@ -90,32 +89,31 @@ auto main() -> int
     solution["dot"] = "";
     solution["aiger"] = "";
 
-    std::function<std::pair<bool, std::string>(enumeration_tool::partial_dag_enumerator_parallel<mockturtle::aig_network, mockturtle::aig_network::signal, EnumerationSymbols>*, const std::shared_ptr<mockturtle::aig_network>&)>
-      use_formula =
-      [&](enumeration_tool::partial_dag_enumerator_parallel<mockturtle::aig_network, mockturtle::aig_network::signal, EnumerationSymbols>* enumerator, const std::shared_ptr<mockturtle::aig_network>& ntk) -> std::pair<bool, std::string> {
+    using enumerator_t = enumeration_tool::partial_dag_enumerator_parallel<mockturtle::aig_network, mockturtle::aig_network::signal, EnumerationSymbols>;
+
+    // the TTs come from the engine, no network is built for the candidates
+    enumerator_t::candidate_callback_t use_candidate =
+      [&](const enumerator_t::candidate_view& candidate) -> bool {
         obtained_num_formulas++;
-        const auto tt = mockturtle::simulate<kitty::dynamic_truth_table>(*ntk, sim);
-        const auto value = kitty::to_hex(tt[0]);
-        if (tts[i].second == value) {
-          std::cout << fmt::format("Found {}!!", value) << std::endl;
+        if (candidate.root_tt() == tts[i].first) {
+          std::cout << fmt::format("Found {}!!", tts[i].second) << std::endl;
           solution["result"] = "solution";
-          return {true, value};
+          return true;
         }
-        return {false, value};
+        return false;
       };
 
     auto aig_interface = std::make_shared<aig_enumeration_interface>();
     auto generic_interface = std::static_pointer_cast<enumeration_interface<mockturtle::aig_network, mockturtle::aig_network::signal, EnumerationSymbols>>(aig_interface);
 
-    enumeration_tool::partial_dag_enumerator_parallel<mockturtle::aig_network, mockturtle::aig_network::signal, EnumerationSymbols> en(store.build_grammar(), generic_interface, use_formula);
+    enumerator_t en(store.build_grammar(), generic_interface);
+    en._use_candidate_callback = use_candidate;
+    en.max_block_size = 1024;
+    en.limits.set_timeout(std::chrono::seconds(60));
 
     auto duration = en.enumeration_time;
 
-    try {
-      en.enumerate_aig_pre_enumeration(generated, num_workers);
-    } catch (const std::runtime_error& e) {
-      std::cerr << e.what() << std::endl;
-    }
+    en.enumerate_aig_pre_enumeration(generated, num_workers);
 
     if (false && duration == 0) {
       std::cout << "Duration is too short... Remeasuring!\n";
@@ -155,6 +153,9 @@ auto main() -> int
       solution["aiger"] = en.circuit;
       solution["time"] = en.enumeration_time;
     }
+    else if (en.status == enumeration_tool::enumeration_status::timeout) {
+      solution["num_formulas"] = obtained_num_formulas.load();
+    }
     std::cout << "Enumeration time: " << en.enumeration_time << std::endl;
     std::cout << "Num formulas: " << obtained_num_formulas << std::endl;
     j.emplace_back(solution);
@@ -213,8 +214,8 @@ void runtime_test() {
     solution["dot"] = "";
     solution["aiger"] = "";
 
-    std::function<std::pair<bool, std::string>(enumerator_t*, const std::shared_ptr<mockturtle::aig_network>&)> use_formula =
-      [&](enumerator_t* enumerator, const std::shared_ptr<mockturtle::aig_network>& ntk) -> std::pair<bool, std::string> {
+    enumerator_t::callback_t use_formula =
+      [&](enumerator_t* enumerator, const std::shared_ptr<mockturtle::aig_network>& ntk) -> enumerator_t::callback_result {
         obtained_num_formulas++;
         const auto tt = mockturtle::simulate<kitty::dynamic_truth_table>(*ntk, sim);
         const auto value = kitty::to_hex(tt[0]);
@@ -223,9 +224,9 @@ void runtime_test() {
         if (goal == value) {
           std::cout << fmt::format("Found {}!!", value) << std::endl;
           solution["result"] = "solution";
-          return {true, value};
+          return {true, tt[0]};
         }
-        return {false, value};
+        return {false, tt[0]};
       };
 
     auto aig_interface = std::make_shared<aig_enumeration_interface>();
@@ -0,0 +1,267 @@
+/* MIT License
+ *
+ * Copyright (c) 2020 Gianluca Martino
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+namespace enumeration_tool {
+
+// TTs with a value each, the words of the TTs one after the other: the enumeration only copies them, they are
+// formatted by the checkpoint_writer
+struct truth_table_words {
+  uint32_t num_words = 0; // of each TT
+  std::vector<uint64_t> words;
+  std::vector<uint64_t> values;
+
+  template<typename TruthTable>
+  void emplace_back(const TruthTable& tt, uint64_t value) {
+    num_words = static_cast<uint32_t>(tt.num_blocks());
+    words.insert(words.end(), tt.cbegin(), tt.cend());
+    values.emplace_back(value);
+  }
+
+  void append(const truth_table_words& other) {
+    if (other.values.empty()) {
+      return;
+    }
+    if (!values.empty() && num_words != other.num_words) {
+      throw std::runtime_error("The checkpoint was written for another number of inputs");
+    }
+    num_words = other.num_words;
+    words.insert(words.end(), other.words.begin(), other.words.end());
+    values.insert(values.end(), other.values.begin(), other.values.end());
+  }
+
+  // fn(tt, value), tt is the buffer of the TTs
+  template<typename TruthTable, typename Fn>
+  void foreach_entry(TruthTable& tt, Fn&& fn) const {
+    if (!values.empty() && num_words != static_cast<uint32_t>(tt.num_blocks())) {
+      throw std::runtime_error("The checkpoint was written for another number of inputs");
+    }
+    for (auto i = 0ul; i < values.size(); ++i) {
+      std::copy_n(words.cbegin() + i * num_words, num_words, tt.begin());
+      fn(tt, values[i]);
+    }
+  }
+};
+
+inline void to_json(nlohmann::json& j, const truth_table_words& table) {
+  j = {{"num_words", table.num_words}, {"words", table.words}, {"values", table.values}};
+}
+
+inline void from_json(const nlohmann::json& j, truth_table_words& table) {
+  table.num_words = j.at("num_words").get<uint32_t>();
+  table.words = j.at("words").get<std::vector<uint64_t>>();
+  table.values = j.at("values").get<std::vector<uint64_t>>();
+}
+
+// State of an interrupted enumeration, saved in CBOR with the TTs as raw words. An incremental checkpoint only holds
+// the entries added to the tables since the previous one: the checkpoint_writer merges it into the whole state.
+struct enumeration_checkpoint {
+  struct target_entry {
+    std::vector<uint64_t> tt;
+    int dag_index;
+    std::vector<int> assignment;
+    int nr_gates;
+  };
+
+  int dag_index = 0;
+  std::vector<int> assignment; // for each vertex the position in its possible assignments
+  std::vector<bool> gray_directions; // serial engine, Gray code order
+  truth_table_words minimal_sizes;
+  std::vector<truth_table_words> seen_tts; // serial engine, for each vertex of the current DAG
+  std::vector<target_entry> target_solutions; // serial engine, multi-target mode
+  std::vector<std::vector<std::vector<int>>> duplicated_assignments; // parallel engine, for each DAG
+  std::vector<std::pair<int, std::vector<int>>> in_flight; // parallel engine, candidates not completed yet (DAG index, symbols)
+
+  // not saved
+  bool incremental = false; // minimal_sizes, seen_tts and target_solutions
+  bool restart_seen_tts = false; // incremental: the seen_tts of the previous checkpoints belong to another DAG
+
+  void merge(enumeration_checkpoint&& next) {
+    if (!next.incremental) {
+      *this = std::move(next);
+      return;
+    }
+    dag_index = next.dag_index;
+    assignment = std::move(next.assignment);
+    gray_directions = std::move(next.gray_directions);
+    minimal_sizes.append(next.minimal_sizes);
+    if (next.restart_seen_tts) {
+      seen_tts = std::move(next.seen_tts);
+    }
+    else {
+      seen_tts.resize(std::max(seen_tts.size(), next.seen_tts.size()));
+      for (auto i = 0ul; i < next.seen_tts.size(); ++i) {
+        seen_tts[i].append(next.seen_tts[i]);
+      }
+    }
+    std::move(next.target_solutions.begin(), next.target_solutions.end(), std::back_inserter(target_solutions));
+  }
+
+  void save(const std::string& filename) const {
+    nlohmann::json j;
+    j["dag_index"] = dag_index;
+    j["assignment"] = assignment;
+    j["gray_directions"] = gray_directions;
+    j["minimal_sizes"] = minimal_sizes;
+    j["seen_tts"] = seen_tts;
+    j["target_solutions"] = nlohmann::json::array();
+    for (const auto& target : target_solutions) {
+      j["target_solutions"].push_back({{"tt", target.tt}, {"dag_index", target.dag_index}, {"assignment", target.assignment}, {"nr_gates", target.nr_gates}});
+    }
+    j["duplicated_assignments"] = duplicated_assignments;
+    j["in_flight"] = in_flight;
+
+    // the previous checkpoint is replaced only once the new one is complete
+    auto temporary = filename + ".tmp";
+    {
+      auto bytes = nlohmann::json::to_cbor(j);
+      std::ofstream ofs(temporary, std::ios::binary);
+      ofs.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+      if (!ofs) {
+        throw std::runtime_error("Cannot write the checkpoint " + temporary);
+      }
+    }
+    if (std::rename(temporary.c_str(), filename.c_str()) != 0) {
+      throw std::runtime_error("Cannot write the checkpoint " + filename);
+    }
+  }
+
+  static auto load(const std::string& filename) -> enumeration_checkpoint {
+    std::ifstream ifs(filename, std::ios::binary);
+    if (!ifs) {
+      throw std::runtime_error("Cannot read the checkpoint " + filename);
+    }
+    std::vector<uint8_t> bytes{std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>()};
+    auto j = nlohmann::json::from_cbor(bytes);
+
+    enumeration_checkpoint checkpoint;
+    checkpoint.dag_index = j.at("dag_index").get<int>();
+    checkpoint.assignment = j.at("assignment").get<std::vector<int>>();
+    checkpoint.gray_directions = j.at("gray_directions").get<std::vector<bool>>();
+    checkpoint.minimal_sizes = j.at("minimal_sizes").get<truth_table_words>();
+    checkpoint.seen_tts = j.at("seen_tts").get<std::vector<truth_table_words>>();
+    for (const auto& target : j.at("target_solutions")) {
+      checkpoint.target_solutions.push_back({target.at("tt").get<std::vector<uint64_t>>(), target.at("dag_index").get<int>(), target.at("assignment").get<std::vector<int>>(), target.at("nr_gates").get<int>()});
+    }
+    checkpoint.duplicated_assignments = j.at("duplicated_assignments").get<std::vector<std::vector<std::vector<int>>>>();
+    checkpoint.in_flight = j.at("in_flight").get<std::vector<std::pair<int, std::vector<int>>>>();
+    return checkpoint;
+  }
+};
+
+// Writes the checkpoints from a background thread: the enumeration only hands over a snapshot of its state, or the
+// changes since the previous one. The snapshots waiting to be written are merged, only the last state is written.
+class checkpoint_writer {
+public:
+  explicit checkpoint_writer(std::string filename)
+    : _filename{ std::move(filename) }
+    , _thread{ [this] { run(); } }
+  {}
+
+  ~checkpoint_writer() {
+    {
+      std::scoped_lock lock(_mutex);
+      _stop = true;
+    }
+    _condition.notify_one();
+    _thread.join();
+  }
+
+  checkpoint_writer(const checkpoint_writer&) = delete;
+  auto operator=(const checkpoint_writer&) -> checkpoint_writer& = delete;
+
+  void post(enumeration_checkpoint checkpoint) {
+    {
+      std::scoped_lock lock(_mutex);
+      if (!checkpoint.incremental) {
+        _pending.clear(); // replaced
+      }
+      _pending.emplace_back(std::move(checkpoint));
+    }
+    _condition.notify_one();
+  }
+
+  [[nodiscard]]
+  auto written() const -> int {
+    std::scoped_lock lock(_mutex);
+    return _written;
+  }
+
+protected:
+  void run() {
+    std::unique_lock lock(_mutex);
+    while (true) {
+      _condition.wait(lock, [this] { return _stop || !_pending.empty(); });
+      if (!_pending.empty()) {
+        auto pending = std::move(_pending);
+        _pending.clear();
+        lock.unlock();
+        for (auto& checkpoint : pending) {
+          _state.merge(std::move(checkpoint));
+        }
+        auto saved = true;
+        try {
+          _state.save(_filename);
+        } catch (const std::runtime_error& e) {
+          std::cerr << e.what() << std::endl; // the enumeration goes on, the next checkpoint may succeed
+          saved = false;
+        }
+        lock.lock();
+        _written += saved ? 1 : 0;
+        continue;
+      }
+      if (_stop) {
+        return;
+      }
+    }
+  }
+
+  std::string _filename;
+  std::vector<enumeration_checkpoint> _pending;
+  enumeration_checkpoint _state; // writer thread
+  int _written = 0;
+  bool _stop = false;
+  mutable std::mutex _mutex;
+  std::condition_variable _condition;
+  std::thread _thread; // last: started once the other members are initialized
+};
+
+}
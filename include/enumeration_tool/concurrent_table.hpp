@@ -0,0 +1,320 @@
+/* MIT License
+ *
+ * Copyright (c) 2020 Gianluca Martino
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+
+#include <kitty/hash.hpp>
+
+#include "truth_table_traits.hpp"
+
+namespace enumeration_tool {
+
+// Hash table of 64-bit keys and 32-bit values shared by the worker threads: open addressing with linear probing on
+// atomic slots, no locks and no allocation after the construction. The capacity is fixed (rounded up to a power of
+// two), the entries cannot be removed. The table is full at 3/4 of the capacity, so that the probe sequences stay
+// short: the new keys are then refused, nothing throws. The first refusal is final: a refused key never enters later.
+class concurrent_table {
+public:
+  explicit concurrent_table(std::size_t capacity = 1u << 16)
+  {
+    _capacity = 1;
+    while (_capacity < capacity) {
+      _capacity <<= 1u;
+    }
+    _max_size = _capacity - _capacity / 4;
+    _slots = std::make_unique<slot[]>(_capacity);
+  }
+
+  concurrent_table(const concurrent_table&) = delete;
+  auto operator=(const concurrent_table&) -> concurrent_table& = delete;
+
+  // returns false if the key was already there (its value is not changed) or if the table is full
+  auto insert(uint64_t key, uint32_t value = 0) -> bool
+  {
+    auto [s, inserted] = acquire(key, value);
+    return inserted;
+  }
+
+  // inserts the key or lowers its value, previous is set to the value before the update (nothing if the key was not
+  // there); returns false if the key was not there and the table is full
+  auto update_min(uint64_t key, uint32_t value, std::optional<uint32_t>& previous) -> bool
+  {
+    auto [s, inserted] = acquire(key, value);
+    if (s == nullptr) {
+      return false;
+    }
+    if (inserted) {
+      previous = std::nullopt;
+      return true;
+    }
+    auto current = s->value.load(std::memory_order_relaxed);
+    while (value < current && !s->value.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+    previous = current;
+    return true;
+  }
+
+  [[nodiscard]]
+  auto find(uint64_t key) const -> std::optional<uint32_t>
+  {
+    for (auto i = hash(key), probes = std::size_t{ 0 }; probes < _capacity; i = (i + 1) & (_capacity - 1), ++probes) {
+      const auto& s = _slots[i];
+      auto state = wait_ready(s);
+      if (state == empty) {
+        return std::nullopt;
+      }
+      if (s.key.load(std::memory_order_relaxed) == key) {
+        return s.value.load(std::memory_order_relaxed);
+      }
+    }
+    return std::nullopt;
+  }
+
+  [[nodiscard]]
+  auto contains(uint64_t key) const -> bool
+  {
+    return find(key).has_value();
+  }
+
+  // fn(uint64_t key, uint32_t value), the entries inserted meanwhile may be skipped
+  template<typename Fn>
+  void foreach_entry(Fn&& fn) const
+  {
+    for (auto i = 0ul; i < _capacity; ++i) {
+      if (_slots[i].state.load(std::memory_order_acquire) == ready) {
+        fn(_slots[i].key.load(std::memory_order_relaxed), _slots[i].value.load(std::memory_order_relaxed));
+      }
+    }
+  }
+
+  [[nodiscard]]
+  auto size() const -> std::size_t
+  {
+    return _size.load(std::memory_order_relaxed);
+  }
+
+  [[nodiscard]]
+  auto capacity() const -> std::size_t
+  {
+    return _capacity;
+  }
+
+  // once full, the table stays full
+  [[nodiscard]]
+  auto full() const -> bool
+  {
+    return _full.load(std::memory_order_acquire) || size() >= _max_size;
+  }
+
+protected:
+  enum : uint32_t { empty = 0, busy = 1, ready = 2 };
+
+  struct slot {
+    std::atomic<uint64_t> key{ 0 };
+    std::atomic<uint32_t> value{ 0 };
+    std::atomic<uint32_t> state{ empty };
+  };
+
+  // the slot of the key, claimed with the value if the key was not there; no slot if the key was not there and the
+  // table is full
+  // the entry is reserved before claiming the slot and kept if another key takes the slot meanwhile, a reservation
+  // given back would let the size drop below the limit after a refusal
+  auto acquire(uint64_t key, uint32_t value) -> std::pair<slot*, bool>
+  {
+    bool reserved = false;
+    for (auto i = hash(key), probes = std::size_t{ 0 }; probes < _capacity; i = (i + 1) & (_capacity - 1), ++probes) {
+      auto& s = _slots[i];
+      auto state = s.state.load(std::memory_order_acquire);
+      if (state == empty) {
+        if (!reserved) {
+          if (_full.load(std::memory_order_acquire)) {
+            return {nullptr, false};
+          }
+          if (_size.fetch_add(1, std::memory_order_relaxed) >= _max_size) {
+            _full.store(true, std::memory_order_release);
+            _size.fetch_sub(1, std::memory_order_relaxed);
+            return {nullptr, false};
+          }
+          reserved = true;
+        }
+        auto expected = static_cast<uint32_t>(empty);
+        if (s.state.compare_exchange_strong(expected, busy, std::memory_order_acquire)) {
+          s.key.store(key, std::memory_order_relaxed);
+          s.value.store(value, std::memory_order_relaxed);
+          s.state.store(ready, std::memory_order_release);
+          return {&s, true};
+        }
+      }
+      wait_ready(s);
+      if (s.key.load(std::memory_order_relaxed) == key) {
+        if (reserved) {
+          _size.fetch_sub(1, std::memory_order_relaxed);
+        }
+        return {&s, false};
+      }
+    }
+    return {nullptr, false}; // not reached, a quarter of the slots stays empty
+  }
+
+  // a slot being claimed gets its key shortly after
+  static auto wait_ready(const slot& s) -> uint32_t
+  {
+    auto state = s.state.load(std::memory_order_acquire);
+    while (state == busy) {
+      std::this_thread::yield();
+      state = s.state.load(std::memory_order_acquire);
+    }
+    return state;
+  }
+
+  auto hash(uint64_t key) const -> std::size_t
+  {
+    key ^= key >> 33u;
+    key *= 0xff51afd7ed558ccdull;
+    key ^= key >> 33u;
+    key *= 0xc4ceb9fe1a85ec53ull;
+    key ^= key >> 33u;
+    return static_cast<std::size_t>(key) & (_capacity - 1);
+  }
+
+  std::size_t _capacity;
+  std::size_t _max_size; // 3/4 of the capacity
+  std::unique_ptr<slot[]> _slots;
+  std::atomic<std::size_t> _size{ 0 };
+  std::atomic<bool> _full{ false }; // set by the first refusal
+};
+
+// Minimal sizes by truth table: the functions fitting in a single word are kept in a concurrent_table, the larger ones
+// in maps sharded by hash, with a mutex each. The single-word functions overflow into the shards once the
+// concurrent_table is full. A function refused while another thread inserts it in the concurrent_table ends up in both:
+// the reads take the smaller size.
+template<typename TruthTable>
+class concurrent_size_table {
+public:
+  concurrent_size_table(uint32_t num_vars, std::size_t capacity)
+    : _num_vars{ num_vars }
+    , _small{ num_vars <= 6 ? capacity : 1 }
+  {}
+
+  // inserts the function or lowers its size, returns the size before the update (nothing if the function was not there)
+  auto update_min(const TruthTable& tt, uint32_t size) -> std::optional<uint32_t>
+  {
+    if (tt.num_blocks() == 1) {
+      std::optional<uint32_t> previous;
+      if (_small.update_min(*tt.cbegin(), size, previous)) {
+        return previous;
+      }
+    }
+
+    auto& shard = _shards[kitty::hash<TruthTable>{}(tt) % num_shards];
+    std::scoped_lock lock(shard.mutex);
+    auto [it, inserted] = shard.sizes.emplace(tt, size);
+    if (inserted) {
+      return std::nullopt;
+    }
+    auto previous = it->second;
+    it->second = std::min(it->second, size);
+    return previous;
+  }
+
+  auto insert(const TruthTable& tt, uint32_t size) -> bool
+  {
+    return !update_min(tt, size).has_value();
+  }
+
+  auto find(const TruthTable& tt) const -> std::optional<uint32_t>
+  {
+    std::optional<uint32_t> size;
+    if (tt.num_blocks() == 1) {
+      size = _small.find(*tt.cbegin());
+      if (!_small.full()) {
+        return size;
+      }
+    }
+
+    auto& shard = _shards[kitty::hash<TruthTable>{}(tt) % num_shards];
+    std::scoped_lock lock(shard.mutex);
+    auto it = shard.sizes.find(tt);
+    if (it == shard.sizes.end()) {
+      return size;
+    }
+    return size ? std::min(*size, it->second) : it->second;
+  }
+
+  // fn(const TruthTable& tt, uint32_t size)
+  template<typename Fn>
+  void foreach_entry(Fn&& fn) const
+  {
+    auto tt = truth_table_traits<TruthTable>::construct(_num_vars);
+    if (tt.num_blocks() == 1) {
+      _small.foreach_entry([&](uint64_t word, uint32_t size) {
+        *tt.begin() = word;
+        fn(tt, find(tt).value_or(size));
+      });
+    }
+
+    for (auto& shard : _shards) {
+      std::scoped_lock lock(shard.mutex);
+      for (const auto& [function, size] : shard.sizes) {
+        if (function.num_blocks() == 1 && _small.contains(*function.cbegin())) {
+          continue; // given with the concurrent_table
+        }
+        fn(function, size);
+      }
+    }
+  }
+
+  [[nodiscard]]
+  auto size() const -> std::size_t
+  {
+    auto result = _small.size();
+    for (auto& shard : _shards) {
+      std::scoped_lock lock(shard.mutex);
+      result += shard.sizes.size();
+    }
+    return result;
+  }
+
+protected:
+  static constexpr std::size_t num_shards = 64;
+
+  struct shard {
+    mutable std::mutex mutex;
+    std::unordered_map<TruthTable, uint32_t, kitty::hash<TruthTable>> sizes;
+  };
+
+  uint32_t _num_vars;
+  concurrent_table _small;
+  std::array<shard, num_shards> _shards;
+};
+
+}
@@ -0,0 +1,99 @@
+/* MIT License
+ *
+ * Copyright (c) 2020 Gianluca Martino
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+
+namespace enumeration_tool {
+
+// how an enumeration ended
+enum class enumeration_status {
+  running,
+  completed, // all the candidates were processed
+  stopped, // by the callback
+  cancelled, // by the cancellation token
+  timeout, // the deadline was reached
+  budget_exhausted // max_candidates were processed
+};
+
+// shared between the copies: cancel() from any thread stops the enumerations holding one of them
+class cancellation_token {
+public:
+  void cancel() const
+  {
+    _cancelled->store(true, std::memory_order_relaxed);
+  }
+
+  [[nodiscard]]
+  auto is_cancelled() const -> bool
+  {
+    return _cancelled->load(std::memory_order_relaxed);
+  }
+
+protected:
+  std::shared_ptr<std::atomic<bool>> _cancelled = std::make_shared<std::atomic<bool>>(false);
+};
+
+// Budget of an enumeration, checked by the engines every check_period candidates (of each worker for the parallel
+// ones): the enumeration then ends as if it was over, with the status telling why.
+struct enumeration_limits {
+  cancellation_token token;
+  std::optional<std::chrono::steady_clock::time_point> deadline;
+  uint64_t max_candidates = 0; // 0: no limit
+  unsigned check_period = 1024; // 0 is taken as 1
+
+  void set_timeout(std::chrono::steady_clock::duration timeout)
+  {
+    deadline = std::chrono::steady_clock::now() + timeout;
+  }
+
+  [[nodiscard]]
+  auto period() const -> unsigned
+  {
+    return std::max(check_period, 1u);
+  }
+
+  // nothing if the enumeration can go on
+  [[nodiscard]]
+  auto check(uint64_t num_candidates) const -> std::optional<enumeration_status>
+  {
+    if (token.is_cancelled()) {
+      return enumeration_status::cancelled;
+    }
+    if (max_candidates > 0 && num_candidates >= max_candidates) {
+      return enumeration_status::budget_exhausted;
+    }
+    if (deadline && std::chrono::steady_clock::now() >= *deadline) {
+      return enumeration_status::timeout;
+    }
+    return std::nullopt;
+  }
+};
+
+}
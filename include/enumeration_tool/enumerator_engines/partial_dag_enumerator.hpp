@@ -23,27 +23,44 @@
 
 #pragma once
 
+#include <array>
+#include <chrono>
+#include <type_traits>
+
 #include <fmt/format.h>
 #include <fmt/ranges.h>
+#include <kitty/bit_operations.hpp>
+#include <kitty/constructors.hpp>
+#include <kitty/npn.hpp>
 #include <magic_enum.hpp>
 #include <range/v3/core.hpp>
 #include <range/v3/view/transform.hpp>
 #include <range/v3/view/indirect.hpp>
 #include <robin_hood.h>
 
+#include "../checkpoint.hpp"
+#include "../enumeration_limits.hpp"
 #include "../grammar.hpp"
+#include "../minimum_size_database.hpp"
+#include "../network_pool.hpp"
 #include "../partial_dag/partial_dag.hpp"
 #include "../partial_dag/partial_dag3_generator.hpp"
 #include "../partial_dag/partial_dag_generator.hpp"
 #include "../symbol.hpp"
+#include "../truth_table_interner.hpp"
+#include "../truth_table_traits.hpp"
 #include "../utils.hpp"
 
 namespace enumeration_tool {
 
-template<typename EnumerationType, typename NodeType, typename SymbolType>
+template<typename EnumerationType, typename NodeType, typename SymbolType, typename TruthTable, typename GrammarDescription>
 class partial_dag_enumerator;
 
-template<typename EnumerationType, typename NodeType, typename SymbolType = uint32_t>
+// TruthTable is the simulation policy: kitty::static_truth_table<N> (N <= 6) keeps every simulated function in a
+// single word, kitty::dynamic_truth_table supports any number of inputs
+// GrammarDescription (optional) is the compile-time description the grammar was built from (see static_grammar.hpp):
+// if given, nodes are simulated and constructed through its static switch instead of the std::function callbacks
+template<typename EnumerationType, typename NodeType, typename SymbolType = uint32_t, typename TruthTable = kitty::dynamic_truth_table, typename GrammarDescription = void>
 class partial_dag_enumerator {
 public:
 
@@ -51,18 +68,33 @@ public:
     Nothing, NextDag, NextAssignment, StopEnumeration, DoNotIncrease
   };
 
-  using callback_t = std::function<void(partial_dag_enumerator<EnumerationType, NodeType, SymbolType>*)>;
+  using truth_table_t = TruthTable;
+
+  struct target_solution {
+    int dag_index; // index in the DAGs given to enumerate_aig_pre_enumeration
+    std::vector<int> assignment;
+    int nr_gates;
+  };
+  using callback_t = std::function<void(partial_dag_enumerator<EnumerationType, NodeType, SymbolType, TruthTable, GrammarDescription>*)>;
 
   partial_dag_enumerator(
-    const grammar<EnumerationType, NodeType, SymbolType>& symbols,
-    std::shared_ptr<enumeration_interface<EnumerationType, NodeType, SymbolType>> interface,
+    const grammar<EnumerationType, NodeType, SymbolType, TruthTable>& symbols,
+    std::shared_ptr<enumeration_interface<EnumerationType, NodeType, SymbolType, TruthTable>> interface,
     callback_t use_formula_callback = nullptr
   )
     : _symbols{ symbols }
     , _interface{ interface }
     , _use_formula_callback{ use_formula_callback }
+    , _interner{ static_cast<uint32_t>(symbols.get_num_terminal_symbols()) }
   {
     minimal_sizes.reserve(256);
+    if (_interner.is_direct()) { // up to 4 inputs: the maps are arrays indexed by the value of the truth table
+      _input_ids.reserve(_interner.size());
+      _gate_ids.reserve(_interner.size());
+      _minimal_size_ids.reserve(_interner.size());
+      _npn_minimal_size_ids.reserve(_interner.size());
+      _npn_classes.reserve(_interner.size());
+    }
   }
 
   [[nodiscard]]
@@ -111,20 +143,47 @@ public:
     return os.str();
   }
 
+  // with a database: minimal_sizes starts from its content and the new minimal sizes are appended to it at the end
+  // with a checkpoint_filename: the state is written there every checkpoint_interval, see resume()
   void enumerate_aig_pre_enumeration(const std::vector<percy::partial_dag>& pdags)
   {
-    current_dag_aig_pre_enumeration = -1;
+    run(pdags, nullptr);
+  }
+
+  // continues the enumeration of pdags from a checkpoint (the multi-target configuration has to be set again)
+  void resume(const std::vector<percy::partial_dag>& pdags, const enumeration_checkpoint& checkpoint)
+  {
+    auto tt = truth_table_traits<TruthTable>::construct(_symbols.get_num_terminal_symbols());
+    minimal_sizes.clear();
+    checkpoint.minimal_sizes.foreach_entry(tt, [&](const TruthTable& function, uint64_t size) {
+      minimal_sizes.emplace(function, static_cast<int>(size));
+    });
+    target_solutions.clear();
+    for (const auto& target : checkpoint.target_solutions) {
+      target_solutions.emplace(tt_from_words(target.tt), target_solution{target.dag_index, target.assignment, target.nr_gates});
+    }
+
+    run(pdags, &checkpoint);
+  }
+
+  void enumerate_pdags(const std::vector<percy::partial_dag>& pdags, const enumeration_checkpoint* checkpoint = nullptr)
+  {
+    auto first_dag = checkpoint != nullptr ? checkpoint->dag_index : 0;
+    current_dag_aig_pre_enumeration = first_dag - 1;
     _dags.clear();
     _dags.emplace_back();
     assert(_dags.size() == 1);
     _current_dag = 0;
 
-    for (int i = 0; i < static_cast<int>(pdags.size()); ++i) {
+    for (int i = first_dag; i < static_cast<int>(pdags.size()); ++i) {
       ++current_dag_aig_pre_enumeration;
       std::cout << fmt::format("Graph {}", current_dag_aig_pre_enumeration) << std::endl;
 
       _dags[_current_dag] = pdags[i];
       initialize();
+      if (checkpoint != nullptr && i == checkpoint->dag_index) {
+        restore_position(*checkpoint);
+      }
 
       while (true) {
         if (i == 8 && _dags[0].get_vertices().size() == 12 && *_current_assignments[11] == 5 && *_current_assignments[10] == 3 && *_current_assignments[9] == 5 && *_current_assignments[8] == 5 && *_current_assignments[7] == 3 && *_current_assignments[6] == 5 /* && *_current_assignments[5] == 1*/) {
@@ -152,18 +211,52 @@ public:
         }
         if (_next_task == Task::StopEnumeration) {
           _next_task = Task::Nothing;
-          break;
+          return;
+        }
+
+        if (_unchecked_candidates == 0) { // the first candidate of each period
+          if (auto reason = limits.check(num_candidates)) {
+            status = *reason;
+            return;
+          }
+        }
+        if (++_unchecked_candidates == limits.period()) {
+          _unchecked_candidates = 0;
+        }
+        ++num_candidates;
+
+        if (_checkpoint_writer && ++_candidates_since_checkpoint >= checkpoint_period) {
+          _candidates_since_checkpoint = 0;
+          if (std::chrono::steady_clock::now() - _last_checkpoint >= checkpoint_interval) {
+            _checkpoint_writer->post(make_checkpoint());
+            _last_checkpoint = std::chrono::steady_clock::now();
+          }
         }
 
         auto duplicate_result = formula_is_duplicate();
         if (duplicate_result < 0) {
           auto tts_result = update_tts();
-          if (minimal_sizes.find(get_root_tt()) == minimal_sizes.end()) {
+          auto root_id = _tt_ids[_dags[_current_dag].get_last_vertex_index()];
+          if (!_minimal_size_ids.contains(root_id)) {
             minimal_sizes.insert({get_root_tt(), _dags[_current_dag].nr_gates_vertices});
+            if (_checkpoint_writer) {
+              _checkpoint_changes.minimal_sizes.emplace_back(get_root_tt(), _dags[_current_dag].nr_gates_vertices);
+            }
+            index_minimal_size(root_id, _dags[_current_dag].nr_gates_vertices);
+            if (database) {
+              database->insert(get_root_tt(), _dags[_current_dag].nr_gates_vertices, current_dag_aig_pre_enumeration, get_current_assignment());
+            }
+          }
+          if (_num_targets > 0) {
+            record_target();
           }
           if (_use_formula_callback != nullptr) {
             _use_formula_callback(this);
           }
+          if (_next_task == Task::StopEnumeration) {
+            _next_task = Task::Nothing;
+            return;
+          }
           if (tts_result > -1) {
             increase_stack_at_position(tts_result);
           }
@@ -188,30 +281,104 @@ public:
     }
   }
 
-  auto get_root_tt() -> kitty::dynamic_truth_table {
+  // multi-target mode: the DAGs are enumerated once and the first circuit found for each target is recorded, the
+  // enumeration stops as soon as every target is covered (the first circuit is a minimum one if the DAGs are sorted by
+  // number of gates, as generate_dags does)
+  // per_npn_class: a target is covered by any function of its NPN class, target_solutions is keyed by the NPN
+  // representatives
+  void set_targets(const std::vector<TruthTable>& targets, bool per_npn_class = false) {
+    _targets.clear();
+    for (const auto& target : targets) {
+      _targets.emplace(per_npn_class ? npn_representative(target) : target);
+    }
+    _num_targets = _targets.size();
+    _npn_targets = per_npn_class;
+    target_solutions.clear();
+  }
+
+  // all the functions (or NPN classes) of the terminal symbols (up to 4 inputs)
+  void set_all_targets(bool per_npn_class = false) {
+    static constexpr std::array<std::size_t, 5> nr_npn_classes = {1, 2, 4, 14, 222};
+
+    auto num_vars = _symbols.get_num_terminal_symbols();
+    if (num_vars > 4) {
+      throw std::runtime_error("Too many inputs for enumerating all the functions");
+    }
+    _targets.clear();
+    _num_targets = per_npn_class ? nr_npn_classes[num_vars] : std::size_t(1) << (1u << num_vars);
+    _npn_targets = per_npn_class;
+    target_solutions.clear();
+  }
+
+  // the canonization of each TT is computed once
+  auto npn_representative(const TruthTable& tt) -> const TruthTable& {
+    auto it = _npn_representatives.find(tt);
+    if (it == _npn_representatives.end()) {
+      it = _npn_representatives.emplace(tt, std::get<0>(kitty::exact_npn_canonization(tt))).first;
+    }
+    return it->second;
+  }
+
+  // the ID of the NPN representative, canonized once for each ID
+  auto npn_class(uint32_t id) -> uint32_t {
+    if (const auto* representative = _npn_classes.find(id)) {
+      return *representative;
+    }
+    auto representative = _interner.intern(std::get<0>(kitty::exact_npn_canonization(_interner.truth_table(id))));
+    _npn_classes.emplace(id, representative);
+    return representative;
+  }
+
+  [[nodiscard]]
+  auto all_targets_covered() const -> bool {
+    return _num_targets > 0 && target_solutions.size() == _num_targets;
+  }
+
+  // sets the DAG and the assignment of a recorded target: to_enumeration_type() and to_dot() then refer to it
+  void load_target_solution(const std::vector<percy::partial_dag>& pdags, const target_solution& solution) {
+    _dags.clear();
+    _dags.emplace_back(pdags[solution.dag_index]);
+    _current_dag = 0;
+    initialize();
+    for (auto i = 0ul; i < _current_assignments.size(); ++i) {
+      _current_assignments[i] = std::find(_possible_assignments[i].cbegin(), _possible_assignments[i].cend(), solution.assignment[i]);
+      assert(_current_assignments[i] != _possible_assignments[i].cend());
+    }
+    update_tts();
+    _next_task = Task::Nothing;
+  }
+
+  // from the callback: the enumeration ends after the current candidate
+  void stop() {
+    _next_task = Task::StopEnumeration;
+    status = enumeration_status::stopped;
+  }
+
+  auto get_root_tt() const -> const TruthTable& {
     return _tts[_dags[_current_dag].get_last_vertex_index()].second;
   }
 
+  // the network is taken from a pool: it is overwritten by the next call unless the caller keeps a reference to it
   auto to_enumeration_type() -> std::shared_ptr<EnumerationType> {
 //    START_CLOCK();
 
-    _interface->construct();
-    // the unsigned here represents the index in the vector obtained from get_symbol_types()
-    std::unordered_map<unsigned, NodeType> leaf_nodes;
-    std::unordered_map<unsigned, NodeType> sub_components;
-
+    _interface->_shared_object_store.reset(); // the network of the previous candidate can go back to the pool
     // adding all possible inputs to the network this is needed because otherwise there is no relation between the signal and the position in the TT
-    NodeType formula;
-    for (int i = 0; i < _symbols.size(); ++i) {
-      if (_symbols[i].num_children == 0) { // this is a leaf
-        formula = _symbols[i].node_constructor(_interface->_shared_object_store, {});
-        leaf_nodes.emplace(i, formula);
+    auto network = _networks.acquire([&](const std::shared_ptr<EnumerationType>& empty, std::vector<NodeType>& leaves) {
+      _interface->_shared_object_store = empty;
+      leaves.resize(_symbols.size());
+      for (auto i = 0u; i < _symbols.size(); ++i) {
+        if (_symbols[i].num_children == 0) { // this is a leaf
+          leaves[i] = construct_node(i, {});
+        }
       }
-    }
+    });
+    _interface->_shared_object_store = network;
 
-    auto node = _dags[_current_dag].get_last_vertex();
-    auto index = _dags[_current_dag].get_last_vertex_index();
-    NodeType head_node = create_node(leaf_nodes, sub_components, node, index);
+    const auto& pdag = _dags[_current_dag];
+    _network_nodes.resize(pdag.nr_vertices());
+    _network_node_created.assign(pdag.nr_vertices(), false);
+    NodeType head_node = create_node(pdag.get_last_vertex_index());
 
     auto output_constructor = _interface->get_output_constructor();
     output_constructor(_interface->_shared_object_store, {head_node});
@@ -223,21 +390,34 @@ public:
 protected:
 
   void check_same_gate(int index) {
-    auto it = _tts_map_gates.find(_tts[index].second);
-    if (it != _tts_map_gates.end()) {
-      auto minimal_index = std::min(_dags[_current_dag].get_minimal_index(index), _dags[_current_dag].get_minimal_index(it->second));
+    if (const auto* other = _gate_ids.find(_tt_ids[index])) {
+      auto minimal_index = std::min(_dags[_current_dag].get_minimal_index(index), _dags[_current_dag].get_minimal_index(*other));
       minimal_indexes.emplace_back(minimal_index);
       simulation_duplicates++;
     }
     else {
-      _tts_map_gates.emplace(_tts[index].second, index);
+      _gate_ids.emplace(_tt_ids[index], index);
     }
   }
 
   void check_coi(int index) {
-    auto it = minimal_sizes.find(_tts[index].second);
-    if (it != minimal_sizes.end()) {
-      if (_dags[_current_dag].get_cois()[index].size() > it->second) { // in this case the TT at this node has been formed with a non minimal structure -> skip
+    if (const auto* size = _minimal_size_ids.find(_tt_ids[index])) {
+      if (_dags[_current_dag].get_cois()[index].size() > *size) { // in this case the TT at this node has been formed with a non minimal structure -> skip
+        minimal_indexes.emplace_back(_dags[_current_dag].get_minimal_index(index));
+        simulation_duplicates++;
+      }
+    }
+  }
+
+  // like check_coi, but compared with the smallest realisation of any function NPN-equivalent to the TT at this node
+  // not applied at the root: the complement of an internal node is absorbed by its parents (as the input complements
+  // by the gates reading them), the complement of the root is not
+  void check_coi_npn(int index) {
+    if (!npn_pruning || index == _dags[_current_dag].get_last_vertex_index()) {
+      return;
+    }
+    if (const auto* size = _npn_minimal_size_ids.find(npn_class(_tt_ids[index]))) {
+      if (_dags[_current_dag].get_cois()[index].size() > *size) {
         minimal_indexes.emplace_back(_dags[_current_dag].get_minimal_index(index));
         simulation_duplicates++;
       }
@@ -245,9 +425,8 @@ protected:
   }
 
   void check_coi_same_size(int index) {
-    auto it = minimal_sizes.find(_tts[index].second);
-    if (it != minimal_sizes.end()) {
-      if (_dags[_current_dag].get_cois()[index].size() == it->second) { // in this case the TT at this node has been formed with an equal size structure -> check if it's the minimal
+    if (const auto* size = _minimal_size_ids.find(_tt_ids[index])) {
+      if (_dags[_current_dag].get_cois()[index].size() == *size) { // in this case the TT at this node has been formed with an equal size structure -> check if it's the minimal
         // TT at this node has been formed with a minimal structure
         // Problem: substructures have conflicting minimal representations in very rare cases
 
@@ -262,9 +441,9 @@ protected:
 //        if (assignments.size() == 9 && assignments[8] == 1 && assignments[7] == 0 && assignments[6] == 4 && assignments[5] == 1 && assignments[4] == 0 && assignments[3] == 6  && assignments[2] == 5  && assignments[1] == 2  && assignments[0] == 4) {
 //          bool stop_here = true;
 //        }
-        auto it_seen = seen_tts[index].find(_tts[index].second);
+        auto it_seen = seen_tts[index].find(_tt_ids[index]);
         if (it_seen == seen_tts[index].end()) { // never seen -> insert
-          seen_tts[index].emplace(_tts[index].second, hash_value);
+          insert_seen_tt(index, _tt_ids[index], hash_value);
 //          seen_tts_debug[index].insert({_tts[index].second, assignments});
         }
         else if (it_seen != seen_tts[index].end() && it_seen->second == hash_value) {} // that's the allowed value -> do nothing
@@ -278,12 +457,41 @@ protected:
   }
 
   void check_inputs(int index) {
-    if (_tts_map_inputs.contains(_tts[index].second)) {
+    if (_input_ids.contains(_tt_ids[index])) {
       minimal_indexes.emplace_back(_dags[_current_dag].get_minimal_index(index));
       simulation_duplicates++;
     }
   };
 
+  // the in-place operation writes directly in the TT of the node, the other one returns a new TT
+  template<typename... Children>
+  void simulate_node(int index, const Children&... children) {
+    const auto& symbol = _symbols[*(_current_assignments[index])];
+    auto& tt = _tts[index].second;
+    if constexpr (!std::is_void_v<GrammarDescription>) {
+      GrammarDescription::evaluate(symbol.type, &*tt.begin(), {&*children.cbegin()...}, tt.num_blocks());
+      tt.mask_bits();
+    }
+    else if (symbol.node_operation_inplace) {
+      symbol.node_operation_inplace(&*tt.begin(), {&*children.cbegin()...}, tt.num_blocks());
+      tt.mask_bits();
+    }
+    else {
+      tt = symbol.node_operation({children...});
+      allocating_node_operations++;
+    }
+    simulated_nodes++;
+  }
+
+  auto construct_node(unsigned symbol, const std::initializer_list<NodeType>& children) -> NodeType {
+    if constexpr (!std::is_void_v<GrammarDescription>) {
+      return GrammarDescription::construct(_symbols[symbol].type, _interface->_shared_object_store, children);
+    }
+    else {
+      return _symbols[symbol].node_constructor(_interface->_shared_object_store, children);
+    }
+  }
+
   void update_tt_(int index) {
     // now lets construct the children nodes
     for (auto input : _dags[_current_dag].get_vertex(index)) {
@@ -297,30 +505,50 @@ protected:
     }
 
     if (_dags[_current_dag].get_num_children(index) == 0) { // end node
-      _tts[index].second = _symbols[*(_current_assignments[index])].node_operation({});
-      _tts_map_inputs.emplace(_tts[index].second, index); // this is an input -> we do nothing because we can have the same input at multiple nodes
+      if (_bit_sliced_active) {
+        bit_sliced_lookup(index);
+      }
+      else {
+        simulate_node(index);
+      }
+      _tt_ids[index] = _interner.intern(_tts[index].second);
+      _input_ids.emplace(_tt_ids[index], index); // this is an input -> we do nothing because we can have the same input at multiple nodes
       _tts[index].first = true;
     }
     else if (_dags[_current_dag].get_num_children(index) == 1) {
       const auto& child = _tts[_dags[_current_dag].get_vertices()[index][0] - 1].second;
-      _tts[index].second = _symbols[*(_current_assignments[index])].node_operation({child});
+      if (_bit_sliced_active) {
+        bit_sliced_lookup(index);
+      }
+      else {
+        simulate_node(index, child);
+      }
+      _tt_ids[index] = _interner.intern(_tts[index].second);
       _tts[index].first = true;
 
       if (_dags[_current_dag].nr_gates_vertices > 3) {
         check_inputs(index);
         check_coi(index);
+        check_coi_npn(index);
         check_same_gate(index);
       }
     }
     else if (_dags[_current_dag].get_num_children(index) == 2) {
       const auto& child0 = _tts[_dags[_current_dag].get_vertices()[index][0] - 1].second;
       const auto& child1 = _tts[_dags[_current_dag].get_vertices()[index][1] - 1].second;
-      _tts[index].second = _symbols[*(_current_assignments[index])].node_operation({child0, child1});
+      if (_bit_sliced_active) {
+        bit_sliced_lookup(index);
+      }
+      else {
+        simulate_node(index, child0, child1);
+      }
+      _tt_ids[index] = _interner.intern(_tts[index].second);
       _tts[index].first = true; // valid
 
       if (_dags[_current_dag].nr_gates_vertices > 3) {
         check_inputs(index);
         check_coi(index);
+        check_coi_npn(index);
         check_same_gate(index);
       }
     }
@@ -344,59 +572,41 @@ protected:
     return -1;
   }
 
-  auto create_node(std::unordered_map<unsigned, NodeType>& leaf_nodes, std::unordered_map<unsigned, NodeType>& sub_components, const std::vector<int>& node, int index) -> NodeType {
-    if (sub_components.find(index) != sub_components.end()) { // the element has already been created
-      return sub_components.find(index)->second;
+  // the gates of the cone of the vertex, the leaves were created with the network
+  auto create_node(int index) -> NodeType {
+    if (_network_node_created[index]) { // the element has already been created
+      return _network_nodes[index];
     }
 
-    std::vector<int> non_zero_nodes;
-
-    // now lets construct the children nodes
-    std::for_each(node.begin(), node.end(), [&](int input){
+    std::array<NodeType, 3> children;
+    auto num_children = 0u;
+    for (auto input : _dags[_current_dag].get_vertex(index)) {
       if (input == 0) { // ignored input node
-        return;
-      }
-      non_zero_nodes.emplace_back(input);
-
-      create_node(leaf_nodes, sub_components, _dags[_current_dag].get_vertex(input - 1), input - 1);
-    });
-
-    NodeType formula;
-
-    if (non_zero_nodes.empty()) { // end node
-      auto map_index = *(_current_assignments[index]);
-      auto leaf_node = leaf_nodes.find(map_index);
-      if (leaf_node != leaf_nodes.end()) { // the node was already created
-        formula = leaf_node->second;
+        continue;
       }
-      else {
-        formula = _symbols[*(_current_assignments[index])].node_constructor(_interface->_shared_object_store, {});
-        leaf_nodes.emplace(map_index, formula);
+      if (num_children == children.size()) {
+        throw std::runtime_error("Number of children of this node not supported in to_enumeration_type");
       }
-      sub_components.emplace(index, formula);
+      children[num_children++] = create_node(input - 1);
     }
-    else if (non_zero_nodes.size() == 1) {
-      auto child = sub_components.find(non_zero_nodes[0] - 1);
-      formula = _symbols[*(_current_assignments[index])].node_constructor(_interface->_shared_object_store, {child->second});
-      sub_components.emplace(index, formula);
+
+    auto symbol = *(_current_assignments[index]);
+    NodeType formula;
+    if (num_children == 0) { // end node
+      formula = _networks.leaves[symbol];
     }
-    else if (non_zero_nodes.size() == 2) {
-      auto child0 = sub_components.find(non_zero_nodes[0] - 1);
-      auto child1 = sub_components.find(non_zero_nodes[1] - 1);
-      formula = _symbols[*(_current_assignments[index])].node_constructor(_interface->_shared_object_store, {child0->second, child1->second});
-      sub_components.emplace(index, formula);
+    else if (num_children == 1) {
+      formula = construct_node(symbol, {children[0]});
     }
-    else if (non_zero_nodes.size() == 3) {
-      auto child0 = sub_components.find(non_zero_nodes[0] - 1);
-      auto child1 = sub_components.find(non_zero_nodes[1] - 1);
-      auto child2 = sub_components.find(non_zero_nodes[2] - 1);
-      formula = _symbols[*(_current_assignments[index])].node_constructor(_interface->_shared_object_store, {child0->second, child1->second, child2->second});
-      sub_components.emplace(index, formula);
+    else if (num_children == 2) {
+      formula = construct_node(symbol, {children[0], children[1]});
     }
     else {
-      throw std::runtime_error("Number of children of this node not supported in to_enumeration_type");
+      formula = construct_node(symbol, {children[0], children[1], children[2]});
     }
 
+    _network_nodes[index] = formula;
+    _network_node_created[index] = true;
     return formula;
   }
 
@@ -454,18 +664,163 @@ protected:
     return -1;
   }
 
+  void run(const std::vector<percy::partial_dag>& pdags, const enumeration_checkpoint* checkpoint) {
+    if (database) {
+      load_database();
+    }
+    _minimal_size_ids.clear();
+    _npn_minimal_size_ids.clear();
+    for (const auto& [tt, size] : minimal_sizes) {
+      index_minimal_size(_interner.intern(tt), size);
+    }
+    if (!checkpoint_filename.empty()) {
+      _checkpoint_writer = std::make_unique<checkpoint_writer>(checkpoint_filename);
+      _candidates_since_checkpoint = 0;
+      _last_checkpoint = std::chrono::steady_clock::now();
+
+      // the first checkpoint has the whole tables, the seen_tts are added by initialize() and restore_position()
+      _checkpoint_changes = {};
+      _checkpoint_changes.incremental = true;
+      for (const auto& [tt, size] : minimal_sizes) {
+        _checkpoint_changes.minimal_sizes.emplace_back(tt, size);
+      }
+      for (const auto& [tt, solution] : target_solutions) {
+        _checkpoint_changes.target_solutions.push_back({{tt.cbegin(), tt.cend()}, solution.dag_index, solution.assignment, solution.nr_gates});
+      }
+    }
+
+    status = enumeration_status::running;
+    num_candidates = 0;
+    _unchecked_candidates = 0;
+    enumerate_pdags(pdags, checkpoint);
+    if (status == enumeration_status::running) {
+      status = enumeration_status::completed;
+    }
+
+    _checkpoint_writer.reset(); // writes the last checkpoint
+    if (database) {
+      database->flush();
+    }
+  }
+
+  // the ID-keyed copy of minimal_sizes used by the pruning
+  void index_minimal_size(uint32_t id, int size) {
+    if (auto* known = _minimal_size_ids.find(id)) {
+      *known = std::min(*known, size);
+    }
+    else {
+      _minimal_size_ids.emplace(id, size);
+    }
+    if (npn_pruning) {
+      auto representative = npn_class(id);
+      if (auto* known = _npn_minimal_size_ids.find(representative)) {
+        *known = std::min(*known, size);
+      }
+      else {
+        _npn_minimal_size_ids.emplace(representative, size);
+      }
+    }
+  }
+
+  auto tt_from_words(const std::vector<uint64_t>& words) const -> TruthTable {
+    auto tt = truth_table_traits<TruthTable>::construct(_symbols.get_num_terminal_symbols());
+    if (words.size() != tt.num_blocks()) {
+      throw std::runtime_error("The checkpoint was written for another number of inputs");
+    }
+    std::copy(words.begin(), words.end(), tt.begin());
+    return tt;
+  }
+
+  // the state before the current candidate is processed: resuming from it processes the same candidate again; only the
+  // entries added to the tables since the previous checkpoint are handed over, the checkpoint_writer thread merges them
+  auto make_checkpoint() -> enumeration_checkpoint {
+    auto checkpoint = std::move(_checkpoint_changes);
+    _checkpoint_changes = {};
+    _checkpoint_changes.incremental = true;
+    _checkpoint_changes.seen_tts.resize(checkpoint.seen_tts.size());
+
+    checkpoint.dag_index = current_dag_aig_pre_enumeration;
+    for (auto i = 0ul; i < _current_assignments.size(); ++i) {
+      checkpoint.assignment.emplace_back(std::distance(_possible_assignments[i].cbegin(), _current_assignments[i]));
+    }
+    if (gray_code_order) {
+      checkpoint.gray_directions = _gray_directions;
+    }
+    return checkpoint;
+  }
+
+  // the TTs are not restored: they are all simulated again for the first candidate
+  void restore_position(const enumeration_checkpoint& checkpoint) {
+    assert(checkpoint.assignment.size() == _current_assignments.size());
+    for (auto i = 0ul; i < _current_assignments.size(); ++i) {
+      _current_assignments[i] = _possible_assignments[i].cbegin() + checkpoint.assignment[i];
+    }
+    if (!checkpoint.gray_directions.empty()) {
+      _gray_directions = checkpoint.gray_directions;
+    }
+    auto tt = truth_table_traits<TruthTable>::construct(_symbols.get_num_terminal_symbols());
+    for (auto i = 0ul; i < checkpoint.seen_tts.size() && i < seen_tts.size(); ++i) {
+      checkpoint.seen_tts[i].foreach_entry(tt, [&](const TruthTable& function, uint64_t hash_value) {
+        insert_seen_tt(i, _interner.intern(function), hash_value);
+      });
+    }
+  }
+
+  void load_database() {
+    auto num_vars = _symbols.get_num_terminal_symbols();
+    database->foreach_entry(num_vars, [&](const uint64_t* words, int32_t size) {
+      auto tt = truth_table_traits<TruthTable>::construct(num_vars);
+      std::copy(words, words + tt.num_blocks(), tt.begin());
+      auto it = minimal_sizes.find(tt);
+      if (it == minimal_sizes.end()) {
+        minimal_sizes.emplace(tt, size);
+      }
+      else {
+        it->second = std::min(it->second, size);
+      }
+    });
+  }
+
+  void insert_seen_tt(int index, uint32_t id, size_t hash_value) {
+    seen_tts[index].emplace(id, hash_value);
+    if (_checkpoint_writer) {
+      _checkpoint_changes.seen_tts[index].emplace_back(_interner.truth_table(id), hash_value);
+    }
+  }
+
+  void record_target() {
+    const auto& tt = _npn_targets ? npn_representative(get_root_tt()) : get_root_tt();
+    if (target_solutions.find(tt) != target_solutions.end()) {
+      return;
+    }
+    if (!_targets.empty() && _targets.find(tt) == _targets.end()) { // empty set of targets: all functions
+      return;
+    }
+
+    target_solutions.emplace(tt, target_solution{current_dag_aig_pre_enumeration, get_current_assignment(), _dags[_current_dag].nr_gates_vertices});
+    if (_checkpoint_writer) {
+      _checkpoint_changes.target_solutions.push_back({{tt.cbegin(), tt.cend()}, current_dag_aig_pre_enumeration, get_current_assignment(), _dags[_current_dag].nr_gates_vertices});
+    }
+    if (target_solutions.size() == _num_targets) {
+      _next_task = Task::StopEnumeration;
+    }
+  }
+
   void initialize() {
     _current_assignments.clear();
     _possible_assignments.clear();
 
     // initialize support structures
-    _tts_map_inputs.clear();
-    _tts_map_inputs.reserve(_dags[_current_dag].nr_vertices());
-    _tts_map_gates.clear();
-    _tts_map_gates.reserve(_dags[_current_dag].nr_vertices());
+    _input_ids.clear();
+    _gate_ids.clear();
+    _tt_ids.assign(_dags[_current_dag].nr_vertices(), truth_table_interner<TruthTable>::npos);
 
     seen_tts.clear();
     seen_tts.resize(_dags[_current_dag].nr_vertices());
+    if (_checkpoint_writer) {
+      _checkpoint_changes.seen_tts.assign(_dags[_current_dag].nr_vertices(), {});
+      _checkpoint_changes.restart_seen_tts = true;
+    }
     seen_tts_debug.clear();
     seen_tts_debug.resize(_dags[_current_dag].nr_vertices());
 
@@ -474,7 +829,7 @@ protected:
     _tts.reserve(_dags[_current_dag].nr_vertices());
     auto num_terminal_symbols = _symbols.get_num_terminal_symbols();
     _dags[_current_dag].foreach_vertex([&](const std::vector<int>& node, int  index) {
-      _tts.emplace_back(false, num_terminal_symbols);
+      _tts.emplace_back(false, truth_table_traits<TruthTable>::construct(num_terminal_symbols));
       _possible_assignments.emplace_back();
       auto nr_of_children = std::count_if(node.begin(), node.end(), [](int i){ return i > 0; });
 
@@ -499,6 +854,7 @@ protected:
     for (const auto& assignment : _possible_assignments) {
       _current_assignments.emplace_back(assignment.begin());
     }
+    _gray_directions.assign(_possible_assignments.size(), true);
 
     for (const auto& possible_assignment : _possible_assignments) {
       if (possible_assignment.empty()) { // this structure doesn't support the current grammar
@@ -507,6 +863,148 @@ protected:
       }
     }
 
+    initialize_bit_sliced();
+  }
+
+  // evaluates the sum of products of the minterms set in code, bitwise over the input words
+  static auto apply_function_code(uint64_t code, const std::array<uint64_t, 3>& inputs, uint32_t arity) -> uint64_t {
+    uint64_t result = 0;
+    for (auto minterm = 0u; minterm < (1u << arity); minterm++) {
+      if (((code >> minterm) & 1u) == 0) {
+        continue;
+      }
+      auto term = ~uint64_t(0);
+      for (auto i = 0u; i < arity; i++) {
+        term &= ((minterm >> i) & 1u) ? inputs[i] : ~inputs[i];
+      }
+      result |= term;
+    }
+    return result;
+  }
+
+  // terminal symbols get their truth table, the other symbols the truth table of the operation over their children
+  // returns false if some operation is not a bitwise function of its children
+  auto compute_symbol_words(uint32_t num_vars) -> bool {
+    std::vector<TruthTable> projections;
+    std::array<uint64_t, 3> projection_words{};
+    for (auto i = 0u; i < std::min(num_vars, 3u); i++) {
+      projections.emplace_back(truth_table_traits<TruthTable>::construct(num_vars));
+      kitty::create_nth_var(projections.back(), i);
+      projection_words[i] = *projections.back().cbegin();
+    }
+
+    std::vector<uint64_t> words;
+    for (const auto& symbol : _symbols.get_nodes()) {
+      if (symbol.num_children == 0) {
+        words.emplace_back(*symbol.node_operation({}).cbegin());
+        continue;
+      }
+      if (symbol.num_children > projections.size()) {
+        return false;
+      }
+
+      auto result = projections[0];
+      switch (symbol.num_children) {
+        case 1: result = symbol.node_operation({projections[0]}); break;
+        case 2: result = symbol.node_operation({projections[0], projections[1]}); break;
+        default: result = symbol.node_operation({projections[0], projections[1], projections[2]}); break;
+      }
+
+      uint64_t code = 0;
+      for (auto minterm = 0u; minterm < (1u << symbol.num_children); minterm++) {
+        code |= uint64_t(kitty::get_bit(result, minterm)) << minterm;
+      }
+      if ((apply_function_code(code, projection_words, symbol.num_children) & _lane_mask) != *result.cbegin()) {
+        return false;
+      }
+      words.emplace_back(code);
+    }
+
+    _symbol_words = std::move(words);
+    return true;
+  }
+
+  void initialize_bit_sliced() {
+    _bit_sliced_active = false;
+
+    auto num_vars = static_cast<uint32_t>(_symbols.get_num_terminal_symbols());
+    if (!bit_sliced_simulation || _bit_sliced_unsupported || num_vars > 5 || _possible_assignments.empty() || _dags[_current_dag].get_num_children(0) != 0) {
+      return;
+    }
+
+    _lane_width = 1u << num_vars;
+    _lane_mask = (uint64_t(1) << _lane_width) - 1;
+    auto nr_lanes = 64u / _lane_width;
+    if (_possible_assignments[0].size() > nr_lanes) {
+      return;
+    }
+
+    if (_symbol_words.empty() && !compute_symbol_words(num_vars)) {
+      _bit_sliced_unsupported = true;
+      return;
+    }
+
+    _lane_broadcast = 0;
+    for (auto lane = 0u; lane < nr_lanes; lane++) {
+      _lane_broadcast |= uint64_t(1) << (lane * _lane_width);
+    }
+
+    _bit_sliced_tts.assign(_possible_assignments.size(), 0);
+    _bit_sliced_flags.assign(_possible_assignments.size(), false);
+    _bit_sliced_active = true;
+  }
+
+  // simulates the node for every possible assignment of slot 0 at once, one lane each
+  auto bit_sliced_tt(int index) -> uint64_t {
+    if (_bit_sliced_flags[index]) {
+      return _bit_sliced_tts[index];
+    }
+
+    std::array<uint64_t, 3> inputs{};
+    auto arity = 0u;
+    for (auto input : _dags[_current_dag].get_vertex(index)) {
+      if (input != 0) {
+        assert(arity < inputs.size());
+        inputs[arity++] = bit_sliced_tt(input - 1);
+      }
+    }
+
+    uint64_t word = 0;
+    if (arity != 0) {
+      word = apply_function_code(_symbol_words[*(_current_assignments[index])], inputs, arity);
+    }
+    else if (index == 0) {
+      auto lane = 0u;
+      for (auto symbol : _possible_assignments[0]) {
+        word |= _symbol_words[symbol] << (lane++ * _lane_width);
+      }
+    }
+    else {
+      word = _symbol_words[*(_current_assignments[index])] * _lane_broadcast;
+    }
+    bit_sliced_nodes++;
+
+    _bit_sliced_tts[index] = word;
+    _bit_sliced_flags[index] = true;
+    return word;
+  }
+
+  void bit_sliced_lookup(int index) {
+    auto lane = std::distance(_possible_assignments[0].cbegin(), _current_assignments[0]);
+    *_tts[index].second.begin() = (bit_sliced_tt(index) >> (lane * _lane_width)) & _lane_mask;
+    simulated_nodes++;
+  }
+
+  void reset_bit_sliced_flags(int index) {
+    if (!_bit_sliced_flags[index]) {
+      return;
+    }
+
+    _bit_sliced_flags[index] = false;
+
+    for (auto parent : _dags[_current_dag].get_parents()[index]) {
+      reset_bit_sliced_flags(parent);
+    }
   }
 
   void set_tts_flags(const std::vector<int>& changed) {
@@ -520,10 +1018,10 @@ protected:
       _tts[index].first = false;
 
       if (index < _dags[_current_dag].nr_PI_vertices) {
-        _tts_map_inputs.erase(_tts[index].second);
+        _input_ids.erase(_tt_ids[index]);
       }
       else {
-        _tts_map_gates.erase(_tts[index].second);
+        _gate_ids.erase(_tt_ids[index]);
       }
 
       for (auto parent : parents[index]) {
@@ -533,11 +1031,63 @@ protected:
 
     for (auto item : changed) {
       set_flags(item);
+      if (_bit_sliced_active && item != 0) { // the lanes cover every assignment of slot 0
+        reset_bit_sliced_flags(item);
+      }
     }
   }
 
+  // reflected mixed-radix Gray code step: every slot below position is moved to the value it would have at the end of
+  // the block of assignments sharing the slots >= position, then the lowest slot >= position that can still move in its
+  // direction is moved by one. Without pruning (position == 0) exactly one slot changes at each step.
+  auto increase_stack_gray(unsigned position) -> bool // this function returns true if it was possible to increase the stack
+  {
+    changed.clear();
+
+    bool flips = false; // parity of the moves done by the higher slots (below position) until the end of the block
+    for (int i = static_cast<int>(position) - 1; i >= 0; --i) {
+      auto size = static_cast<int>(_possible_assignments[i].size());
+      auto current = static_cast<int>(std::distance(_possible_assignments[i].cbegin(), _current_assignments[i]));
+      auto distance = _gray_directions[i] ? size - 1 - current : current; // moves left in the current sweep
+      bool moves = (distance + (flips ? size - 1 : 0)) % 2 == 1;
+
+      _gray_directions[i] = _gray_directions[i] != flips;
+      auto last = _gray_directions[i] ? std::prev(_possible_assignments[i].cend()) : _possible_assignments[i].cbegin();
+      if (_current_assignments[i] != last) {
+        _current_assignments[i] = last;
+        changed.emplace_back(i);
+      }
+      flips = flips != moves;
+    }
+
+    for (auto i = 0u; i < _possible_assignments.size(); i++) {
+      if (i >= position) {
+        if (_gray_directions[i] && std::next(_current_assignments[i]) != _possible_assignments[i].cend()) {
+          ++_current_assignments[i];
+          changed.emplace_back(i);
+          return true;
+        }
+        if (!_gray_directions[i] && _current_assignments[i] != _possible_assignments[i].cbegin()) {
+          --_current_assignments[i];
+          changed.emplace_back(i);
+          return true;
+        }
+      }
+      _gray_directions[i] = !_gray_directions[i]; // this slot reached the end of its sweep -> reflect it
+    }
+
+    return false;
+  }
+
   auto increase_stack_at_position(unsigned position) -> bool // this function returns true if it was possible to increase the stack
   {
+    if (gray_code_order) {
+      auto increase_flag = increase_stack_gray(position);
+      _next_task = increase_flag ? Task::DoNotIncrease : Task::NextDag;
+      set_tts_flags(changed);
+      return increase_flag;
+    }
+
     bool increase_flag = false;
 
     changed.clear();
@@ -572,6 +1122,12 @@ protected:
 
   auto increase_stack() -> bool // this function returns true if it was possible to increase the stack
   {
+    if (gray_code_order) {
+      auto increase_flag = increase_stack_gray(0);
+      set_tts_flags(changed);
+      return increase_flag;
+    }
+
     bool increase_flag = false;
 
     changed.clear();
@@ -596,20 +1152,73 @@ public:
   callback_t _use_formula_callback;
   std::size_t _current_dag = 0;
   std::vector<percy::partial_dag> _dags;
-  const grammar<EnumerationType, NodeType, SymbolType> _symbols;
-  std::shared_ptr<enumeration_interface<EnumerationType, NodeType, SymbolType>> _interface;
+  const grammar<EnumerationType, NodeType, SymbolType, TruthTable> _symbols;
+  std::shared_ptr<enumeration_interface<EnumerationType, NodeType, SymbolType, TruthTable>> _interface;
+  network_pool<EnumerationType, NodeType> _networks;
+  std::vector<NodeType> _network_nodes; // to_enumeration_type(): the signal of each vertex of the DAG
+  std::vector<bool> _network_node_created;
   Task _next_task = Task::Nothing;
-  robin_hood::unordered_flat_map<kitty::dynamic_truth_table, int, kitty::hash<kitty::dynamic_truth_table>> _tts_map_inputs;
-  robin_hood::unordered_flat_map<kitty::dynamic_truth_table, int, kitty::hash<kitty::dynamic_truth_table>> _tts_map_gates;
+  truth_table_interner<TruthTable> _interner; // the TTs seen by the enumeration, the maps below are keyed by their ID
+  std::vector<uint32_t> _tt_ids; // ID of the TT of each vertex, valid with the TT
+  id_map<int> _input_ids; // value: the vertex
+  id_map<int> _gate_ids; // value: the vertex
+  id_map<int> _minimal_size_ids; // same content as minimal_sizes
 
   std::vector<std::vector<unsigned>::const_iterator> _current_assignments;
   std::vector<std::vector<unsigned>> _possible_assignments;
-  std::vector<std::pair<bool, kitty::dynamic_truth_table>> _tts;
-  robin_hood::unordered_flat_map<kitty::dynamic_truth_table, int, kitty::hash<kitty::dynamic_truth_table>> minimal_sizes; // key: TT, value: minimal size
-
 
-  std::deque<robin_hood::unordered_flat_map<kitty::dynamic_truth_table, size_t, kitty::hash<kitty::dynamic_truth_table>>> seen_tts; // an hash map for each gate
-  std::deque<robin_hood::unordered_flat_map<kitty::dynamic_truth_table, std::vector<int>, kitty::hash<kitty::dynamic_truth_table>>> seen_tts_debug; // an hash map for each gate
+  // enumerate the assignments in reflected Gray code order: each step changes a single slot, hence only its fan-out
+  // cone is simulated again
+  bool gray_code_order = false;
+  std::vector<bool> _gray_directions; // true if the slot is moving towards the end of its possible assignments
+
+  // simulate the possible assignments of slot 0 side by side, in lanes of 2^n bits of a single word (n <= 5 inputs):
+  // candidates differing only in slot 0 take their TTs from the lanes instead of being simulated again
+  bool bit_sliced_simulation = false;
+  bool _bit_sliced_active = false; // for the current DAG
+  bool _bit_sliced_unsupported = false; // the grammar has no symbol words, the scalar simulation is used
+  uint32_t _lane_width = 0;
+  uint64_t _lane_mask = 0;
+  uint64_t _lane_broadcast = 0; // a one at the beginning of each lane
+  std::vector<uint64_t> _symbol_words;
+  std::vector<uint64_t> _bit_sliced_tts;
+  std::vector<bool> _bit_sliced_flags; // true if the bit-sliced TT of the node is valid
+  std::vector<std::pair<bool, TruthTable>> _tts;
+
+  // multi-target resources
+  robin_hood::unordered_flat_set<TruthTable, kitty::hash<TruthTable>> _targets;
+  std::size_t _num_targets = 0; // 0: multi-target mode disabled
+  bool _npn_targets = false;
+  robin_hood::unordered_flat_map<TruthTable, int, kitty::hash<TruthTable>> minimal_sizes; // key: TT, value: minimal size
+  robin_hood::unordered_node_map<TruthTable, target_solution, kitty::hash<TruthTable>> target_solutions; // multi-target mode
+
+  std::shared_ptr<minimum_size_database> database; // optional, shared across runs
+
+  // checkpointing: the time is checked every checkpoint_period candidates, the file is written by a background thread
+  std::string checkpoint_filename;
+  std::chrono::milliseconds checkpoint_interval = std::chrono::minutes(10);
+  unsigned checkpoint_period = 4096;
+  std::unique_ptr<checkpoint_writer> _checkpoint_writer;
+  enumeration_checkpoint _checkpoint_changes; // since the previous checkpoint
+  unsigned _candidates_since_checkpoint = 0;
+  std::chrono::steady_clock::time_point _last_checkpoint;
+
+  // cancellation token, deadline and candidate budget; status tells how the last enumeration ended
+  enumeration_limits limits;
+  enumeration_status status = enumeration_status::completed;
+  uint64_t num_candidates = 0; // processed by the last enumeration
+  unsigned _unchecked_candidates = 0; // since the last check of the limits
+
+  // NPN-aware pruning: only sound for grammars in which complementing the inputs of a gate is free (e.g. the AIG grammar
+  // with all the AND variants)
+  bool npn_pruning = false;
+  id_map<int> _npn_minimal_size_ids; // key: ID of the NPN representative, value: minimal size
+  id_map<uint32_t> _npn_classes; // key: ID of the TT, value: ID of its NPN representative
+  robin_hood::unordered_node_map<TruthTable, TruthTable, kitty::hash<TruthTable>> _npn_representatives; // key: TT, value: NPN representative
+
+
+  std::deque<robin_hood::unordered_flat_map<uint32_t, size_t>> seen_tts; // an hash map for each gate, key: ID of the TT
+  std::deque<robin_hood::unordered_flat_map<uint32_t, std::vector<int>>> seen_tts_debug; // an hash map for each gate
 
   //TODO: try with storing the std::vector instead of the int (hash(std::vector))
   long to_enumeration_type_time = 0;
@@ -629,6 +1238,9 @@ public:
   int current_nr_gates;
   int current_dag_aig_pre_enumeration;
   int simulation_duplicates = 0;
+  long simulated_nodes = 0; // number of node TTs computed for the candidates, a lane taken from a bit-sliced node included
+  long bit_sliced_nodes = 0; // number of node operations evaluated on all the lanes at once
+  long allocating_node_operations = 0; // node operations returning a new TT (symbols without an in-place operation)
   int tts_duplicates = 0;
 };
 
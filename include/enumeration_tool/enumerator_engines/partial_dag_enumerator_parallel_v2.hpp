@@ -23,9 +23,15 @@
 
 #pragma once
 
+#include <array>
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
 #include <mutex>
+#include <optional>
 #include <thread>
+#include <unordered_map>
 
 #include <fmt/format.h>
 #include <fmt/ranges.h>
@@ -34,23 +40,27 @@
 #include <range/v3/core.hpp>
 #include <range/v3/view/indirect.hpp>
 #include <range/v3/view/transform.hpp>
-#include <tbb/concurrent_unordered_map.h>
-#include <tbb/concurrent_unordered_set.h>
-#include <tbb/concurrent_vector.h>
 
+#include "../checkpoint.hpp"
+#include "../concurrent_table.hpp"
+#include "../enumeration_limits.hpp"
 #include "../grammar.hpp"
+#include "../minimum_size_database.hpp"
+#include "../mpmc_queue.hpp"
+#include "../network_pool.hpp"
 #include "../partial_dag/partial_dag.hpp"
 #include "../partial_dag/partial_dag3_generator.hpp"
 #include "../partial_dag/partial_dag_generator.hpp"
 #include "../symbol.hpp"
+#include "../truth_table_traits.hpp"
 #include "../utils.hpp"
 
 namespace enumeration_tool {
 
-template<typename EnumerationType, typename NodeType, typename SymbolType>
+template<typename EnumerationType, typename NodeType, typename SymbolType, typename TruthTable>
 class partial_dag_enumerator_parallel;
 
-template<typename EnumerationType, typename NodeType, typename SymbolType = uint32_t>
+template<typename EnumerationType, typename NodeType, typename SymbolType = uint32_t, typename TruthTable = kitty::dynamic_truth_table>
 class partial_dag_enumerator_parallel {
 public:
 
@@ -65,9 +75,43 @@ public:
 
     Task next_task = Task::Nothing;
     unsigned increase_at_position = 0;
+
+    std::vector<TruthTable> tts; // candidate view: one for each vertex, reused across the candidates
+    unsigned unchecked_candidates = 0; // not yet added to num_candidates
+
+    network_pool<EnumerationType, NodeType> networks; // to_enumeration_type()
+    std::vector<NodeType> network_nodes; // the signal of each vertex of the DAG
+    std::vector<bool> network_node_created;
+  };
+
+  // candidate handed to a worker, for the checkpoints
+  struct in_flight_slot {
+    bool busy = false;
+    unsigned pdag_index = 0;
+    std::vector<int> assignment;
+    std::vector<unsigned> block_first; // block claiming: the whole block is processed again on resume
+    std::vector<unsigned> block_last;
+  };
+
+  // assignments of a DAG claimed by a worker, from first to last included (indices in possible_assignments)
+  struct assignment_block {
+    unsigned pdag_index = 0;
+    std::vector<unsigned> first;
+    std::vector<unsigned> last;
+  };
+
+  // the gates of a DAG whose cone has the structure of the DAG pattern, in the order of its vertices
+  struct subgraph_occurrence {
+    unsigned pattern;
+    std::vector<int> positions;
   };
 
   struct enumerator_storage {
+    enumerator_storage(std::size_t table_capacity, uint32_t num_vars)
+      : duplicated_assignments(table_capacity)
+      , minimal_sizes(num_vars, table_capacity)
+    {}
+
     // enumerator stuff
     std::vector<percy::partial_dag> pdags;
     std::vector<std::vector<std::vector<unsigned>>> possible_assignments;
@@ -77,21 +121,69 @@ public:
     std::mutex ca_mutex;
 
     // duplicated assignments stuff
-    std::vector<tbb::concurrent_unordered_set<std::vector<int>, std::hash<std::vector<int>>>> duplicated_assignments; // each pdag has multiple assignments
-    std::vector<tbb::concurrent_vector<std::vector<int>>> positions_in_current_assignment; // for each subgraph
-    tbb::concurrent_unordered_map<unsigned, unsigned> minimal_sizes; // key: HEX value of the truth table converted to unsigned, value: minimal size
-    std::vector<bool> accumulate;
+    concurrent_table duplicated_assignments; // key: see pack_assignment, with the index of the DAG where it was found
+    std::vector<std::vector<subgraph_occurrence>> subgraph_occurrences; // for each DAG
+    concurrent_size_table<TruthTable> minimal_sizes;
+    std::vector<bool> accumulate; // true if the DAG appears as a subgraph of another one
+
+    // simulation pruning, for each DAG and vertex
+    std::vector<std::vector<int>> coi_sizes; // number of gates in the cone, 0 for the leaves
+    std::vector<std::vector<int>> minimal_indices; // smallest vertex in the cone
+
+    // protected by ca_mutex
+    bool finished = false;
+    std::vector<in_flight_slot> in_flight; // one for each worker
+    std::vector<std::pair<int, std::vector<int>>> replay; // in-flight candidates of the checkpoint, processed first
+
+    // pipelined mode: the candidates packed as in duplicated_assignments, for the verifier threads
+    std::unique_ptr<mpmc_queue<uint64_t>> pipeline;
+    std::atomic<bool> producers_done = false;
+    std::atomic<bool> verified_solution = false;
+
+    // deterministic mode: the minimal sizes and the duplicated assignments found are visible to the workers only from
+    // the next group of DAGs, the sizes of the current group are looked up here by the commits
+    bool defer_updates = false;
+    std::unordered_map<TruthTable, uint32_t, kitty::hash<TruthTable>> deferred_minimal_sizes;
+    std::vector<std::pair<unsigned, std::vector<int>>> deferred_duplicates;
+  };
+
+  // a candidate as seen by the candidate callback: the TTs are already simulated, the network is built only on request
+  struct candidate_view {
+    partial_dag_enumerator_parallel* enumerator;
+    const percy::partial_dag& pdag;
+    const std::vector<int>& assignment;
+    const std::vector<TruthTable>& tts;
+    unsigned pdag_index;
+    thread_storage* thread_store = nullptr; // the networks of the worker
+
+    [[nodiscard]]
+    auto root_tt() const -> const TruthTable& {
+      return tts[pdag.get_last_vertex_index()];
+    }
 
-    std::mutex ms_mutex;
+    [[nodiscard]]
+    auto to_enumeration_type() const -> std::shared_ptr<EnumerationType> {
+      if (thread_store != nullptr) {
+        return enumerator->to_enumeration_type(pdag, assignment, *thread_store);
+      }
+      return enumerator->to_enumeration_type(pdag, assignment);
+    }
   };
 
-  using callback_t = std::function<std::pair<bool, std::string>(partial_dag_enumerator_parallel<EnumerationType, NodeType, SymbolType>*, const std::shared_ptr<EnumerationType>&)>;
+  // returned by the formula callback: the engine simulates the candidate if the function is not given
+  struct callback_result {
+    bool stop = false;
+    std::optional<TruthTable> function;
+  };
+
+  using callback_t = std::function<callback_result(partial_dag_enumerator_parallel<EnumerationType, NodeType, SymbolType, TruthTable>*, const std::shared_ptr<EnumerationType>&)>;
+  using candidate_callback_t = std::function<bool(const candidate_view&)>; // returns true to stop the enumeration
   using enumerator_storage_t = struct enumerator_storage;
   using thread_storage_t = struct thread_storage;
 
   partial_dag_enumerator_parallel(
-    const grammar<EnumerationType, NodeType, SymbolType>& symbols,
-    std::shared_ptr<enumeration_interface<EnumerationType, NodeType, SymbolType>> interface,
+    const grammar<EnumerationType, NodeType, SymbolType, TruthTable>& symbols,
+    std::shared_ptr<enumeration_interface<EnumerationType, NodeType, SymbolType, TruthTable>> interface,
     callback_t use_formula_callback = nullptr)
     : _symbols{ symbols }
     , _interface{ interface }
@@ -143,21 +235,122 @@ public:
     return os.str();
   }
 
+  // with a checkpoint_filename: the state is written there every checkpoint_interval, see resume()
   void enumerate_aig_pre_enumeration(const std::vector<percy::partial_dag>& pdags, int num_workers)
   {
-    enumerator_storage_t store;
+    enumerator_storage_t store(table_capacity, _symbols.get_num_terminal_symbols());
+    store.pdags.insert(store.pdags.begin(), pdags.begin(), pdags.end());
+    initialize(store);
+    if (database) {
+      auto tt = truth_table_traits<TruthTable>::construct(_symbols.get_num_terminal_symbols());
+      database->foreach_entry(_symbols.get_num_terminal_symbols(), [&](const uint64_t* words, int32_t size) {
+        std::copy(words, words + tt.num_blocks(), tt.begin());
+        store.minimal_sizes.insert(tt, static_cast<unsigned>(size));
+      });
+    }
+
+    status = enumeration_status::running;
+    num_candidates = 0;
+    enumerate(store, num_workers);
+    auto running = enumeration_status::running;
+    status.compare_exchange_strong(running, enumeration_status::completed);
+    copy_minimal_sizes(store);
+  }
+
+  // continues the enumeration of pdags from a checkpoint, the candidates in flight when it was written are processed
+  // again
+  void resume(const std::vector<percy::partial_dag>& pdags, const enumeration_checkpoint& checkpoint, int num_workers)
+  {
+    enumerator_storage_t store(table_capacity, _symbols.get_num_terminal_symbols());
     store.pdags.insert(store.pdags.begin(), pdags.begin(), pdags.end());
     initialize(store);
 
+    if (checkpoint.dag_index >= static_cast<int>(store.pdags.size())) {
+      store.finished = true;
+    }
+    else {
+      store.current_pdag = checkpoint.dag_index;
+      assert(checkpoint.assignment.size() == store.current_assignments[store.current_pdag].size());
+      for (auto i = 0ul; i < checkpoint.assignment.size(); ++i) {
+        store.current_assignments[store.current_pdag][i] = store.possible_assignments[store.current_pdag][i].cbegin() + checkpoint.assignment[i];
+      }
+    }
+    auto tt = truth_table_traits<TruthTable>::construct(_symbols.get_num_terminal_symbols());
+    checkpoint.minimal_sizes.foreach_entry(tt, [&](const TruthTable& function, uint64_t size) {
+      store.minimal_sizes.insert(function, static_cast<unsigned>(size));
+    });
+    for (auto i = 0ul; i < checkpoint.duplicated_assignments.size() && i < store.pdags.size(); ++i) {
+      for (const auto& assignment : checkpoint.duplicated_assignments[i]) {
+        if (auto key = pack_assignment(i, assignment)) {
+          store.duplicated_assignments.insert(*key);
+        }
+      }
+    }
+    store.replay = checkpoint.in_flight;
+
+    status = enumeration_status::running;
+    num_candidates = 0;
+    enumerate(store, num_workers);
+    auto running = enumeration_status::running;
+    status.compare_exchange_strong(running, enumeration_status::completed);
+    copy_minimal_sizes(store);
+  }
+
+  virtual ~partial_dag_enumerator_parallel() = default;
+
+protected:
+
+  virtual void enumerate(enumerator_storage_t& store, int num_workers)
+  {
+    workers.clear();
+    stop_enumeration = false;
+    store.in_flight.resize(num_workers);
+    initialize_terminal_tts(); // also used by the simulation pruning
+
+    // the checkpoints are taken by a separate thread, the workers only record the candidate they are processing
+    std::unique_ptr<checkpoint_writer> writer;
+    std::thread checkpointer;
+    std::mutex checkpointer_mutex;
+    std::condition_variable checkpointer_condition;
+    bool checkpointer_stop = false;
+    if (!checkpoint_filename.empty()) {
+      writer = std::make_unique<checkpoint_writer>(checkpoint_filename);
+      checkpointer = std::thread([&] {
+        std::unique_lock lock(checkpointer_mutex);
+        while (!checkpointer_condition.wait_for(lock, checkpoint_interval, [&] { return checkpointer_stop; })) {
+          writer->post(make_checkpoint(store));
+        }
+      });
+    }
+
     auto start = std::chrono::steady_clock::now();
 
+    std::vector<std::thread> verifiers;
+    if (verifier_threads > 0) {
+      if (writer) {
+        throw std::runtime_error("Checkpoints are not supported in the pipelined mode");
+      }
+      store.pipeline = std::make_unique<mpmc_queue<uint64_t>>(pipeline_depth);
+      store.producers_done = false;
+      for (int j = 0; j < verifier_threads; ++j) {
+        verifiers.emplace_back([&] { run_verifier(store, start); });
+      }
+    }
+
+    std::vector<thread_storage_t> thread_stores(num_workers);
     for (int j = 0; j < num_workers; ++j) {
-      workers.emplace_back([&] {
+      workers.emplace_back([&, j] {
+        if (max_block_size > 1) {
+          run_blocks(store, thread_stores[j], j, start);
+          return;
+        }
 
-        thread_storage_t thread_store;
+        auto& thread_store = thread_stores[j];
 
         while (true) {
           if (stop_enumeration) {
+            std::scoped_lock lock(store.ca_mutex);
+            store.in_flight[j].busy = false;
             return;
           }
 
@@ -175,6 +368,8 @@ public:
             if (!increase_stack_at_position(store, thread_store.increase_at_position)) {
               thread_store.increase_at_position = 0;
               if (store.current_pdag + 1 >= store.pdags.size()) {
+                store.finished = true;
+                store.in_flight[j].busy = false;
                 stop_enumeration = true;
                 enumeration_time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
                 return;
@@ -189,44 +384,41 @@ public:
             thread_store.pdag_index = store.current_pdag;
             thread_store.pdag = store.pdags[store.current_pdag];
             thread_store.current_assignment = ranges::to<std::vector<int>>(ranges::views::indirect(store.current_assignments[store.current_pdag]));
+            store.in_flight[j] = {true, thread_store.pdag_index, thread_store.current_assignment, {}, {}};
           }
           else {
             thread_store.next_task = Task::Nothing;
 
             std::scoped_lock lock(store.ca_mutex);
-            if (!increase_stack(store)) {
-              if (store.current_pdag + 1 >= store.pdags.size())
-              {
-                stop_enumeration = true;
-                enumeration_time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
-                return;
-              }
-              std::cout << fmt::format("Graph {}", store.current_pdag) << std::endl;
-              store.current_pdag++;
+            if (!store.replay.empty()) {
+              thread_store.pdag_index = store.replay.back().first;
+              thread_store.pdag = store.pdags[thread_store.pdag_index];
+              thread_store.current_assignment = std::move(store.replay.back().second);
+              store.replay.pop_back();
+              store.in_flight[j] = {true, thread_store.pdag_index, thread_store.current_assignment, {}, {}};
             }
+            else {
+              if (store.finished || !increase_stack(store)) {
+                if (store.finished || store.current_pdag + 1 >= static_cast<long>(store.pdags.size()))
+                {
+                  store.finished = true;
+                  store.in_flight[j].busy = false;
+                  stop_enumeration = true;
+                  enumeration_time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+                  return;
+                }
+                std::cout << fmt::format("Graph {}", store.current_pdag) << std::endl;
+                store.current_pdag++;
+              }
 
-            thread_store.pdag_index = store.current_pdag;
-            thread_store.pdag = store.pdags[store.current_pdag];
-            thread_store.current_assignment = ranges::to<std::vector<int>>(ranges::views::indirect(store.current_assignments[store.current_pdag]));
-          }
-
-          if (!formula_is_duplicate(store, thread_store) && _use_formula_callback != nullptr) {
-            auto ntk = to_enumeration_type(thread_store.pdag, thread_store.current_assignment);
-            auto result = _use_formula_callback(this, ntk);
-            if (result.first) {
-              enumeration_time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
-              stop_enumeration = true;
-
-              std::stringstream aiger_output;
-//              mockturtle::write_aiger(*ntk, aiger_output);
-              circuit = aiger_output.str();
-              dot = to_dot(thread_store.pdag, thread_store.current_assignment);
-              current_solution = get_current_solution(thread_store.pdag, thread_store.current_assignment);
-              std::cout << current_solution;
+              thread_store.pdag_index = store.current_pdag;
+              thread_store.pdag = store.pdags[store.current_pdag];
+              thread_store.current_assignment = ranges::to<std::vector<int>>(ranges::views::indirect(store.current_assignments[store.current_pdag]));
+              store.in_flight[j] = {true, thread_store.pdag_index, thread_store.current_assignment, {}, {}};
             }
-
-            duplicate_accumulation(store, thread_store, result.second);
           }
+
+          process_candidate(store, thread_store, start);
           if (thread_store.increase_at_position == 0) {
             thread_store.next_task = Task::Nothing;
           }
@@ -240,93 +432,319 @@ public:
     for (auto& worker : workers) {
       worker.join();
     }
-  }
+    for (auto& thread_store : thread_stores) {
+      flush_candidates(thread_store);
+    }
 
-protected:
+    if (store.pipeline) {
+      store.producers_done = true;
+      for (auto& verifier : verifiers) {
+        verifier.join();
+      }
+      store.pipeline.reset();
+      if (!store.verified_solution) {
+        enumeration_time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+      }
+    }
 
-  auto create_node(const percy::partial_dag& pdag,
-                   const std::vector<int>& current_assignments,
-                   const std::shared_ptr<EnumerationType>& store,
-                   std::unordered_map<unsigned, NodeType>& leaf_nodes,
-                   std::unordered_map<unsigned, NodeType>& sub_components,
-                   std::vector<int> node,
-                   int index) -> NodeType {
-    if (sub_components.find(index) != sub_components.end()) { // the element has already been created
-      return sub_components.find(index)->second;
+    if (writer) {
+      {
+        std::scoped_lock lock(checkpointer_mutex);
+        checkpointer_stop = true;
+      }
+      checkpointer_condition.notify_one();
+      checkpointer.join();
+      writer->post(make_checkpoint(store));
+      writer.reset(); // writes the last checkpoint
     }
 
-    std::vector<int> non_zero_nodes;
+    if (database) {
+      database->flush();
+    }
+  }
 
-    // now lets construct the children nodes
-    std::for_each(node.begin(), node.end(), [&](int input){
-      if (input == 0) { // ignored input node
-        return;
+  // the position and the candidates in flight are read together, only the bounds of the claimed blocks are copied under
+  // the lock; the blocks are expanded and the tables are copied afterwards without stopping the workers (the tables can
+  // only contain more entries than the position implies)
+  auto make_checkpoint(enumerator_storage_t& store) -> enumeration_checkpoint
+  {
+    enumeration_checkpoint checkpoint;
+    std::vector<assignment_block> blocks;
+    {
+      std::scoped_lock lock(store.ca_mutex);
+      if (store.finished) {
+        checkpoint.dag_index = store.pdags.size();
       }
-      non_zero_nodes.emplace_back(input);
+      else {
+        checkpoint.dag_index = store.current_pdag;
+        for (auto i = 0ul; i < store.current_assignments[store.current_pdag].size(); ++i) {
+          checkpoint.assignment.emplace_back(std::distance(store.possible_assignments[store.current_pdag][i].cbegin(), store.current_assignments[store.current_pdag][i]));
+        }
+      }
+      for (const auto& slot : store.in_flight) {
+        if (!slot.busy) {
+          continue;
+        }
+        if (slot.block_last.empty()) {
+          checkpoint.in_flight.emplace_back(slot.pdag_index, slot.assignment);
+        }
+        else {
+          blocks.push_back({slot.pdag_index, slot.block_first, slot.block_last});
+        }
+      }
+      checkpoint.in_flight.insert(checkpoint.in_flight.end(), store.replay.begin(), store.replay.end());
+    }
+
+    for (const auto& block : blocks) { // possible_assignments does not change during the enumeration
+      auto indices = block.first;
+      do {
+        checkpoint.in_flight.emplace_back(block.pdag_index, to_symbols(store, block.pdag_index, indices));
+      } while (advance_indices(store, block.pdag_index, indices, 0) && !precedes(block.last, indices));
+    }
 
-      create_node(pdag, current_assignments, store, leaf_nodes, sub_components, pdag.get_vertex(input - 1), input - 1);
+    store.minimal_sizes.foreach_entry([&](const TruthTable& tt, uint32_t size) {
+      checkpoint.minimal_sizes.emplace_back(tt, size);
     });
+    checkpoint.duplicated_assignments.resize(store.pdags.size());
+    store.duplicated_assignments.foreach_entry([&](uint64_t key, uint32_t) {
+      auto pdag_index = key >> 48u;
+      checkpoint.duplicated_assignments[pdag_index].emplace_back(unpack_assignment(key, store.current_assignments[pdag_index].size()));
+    });
+    return checkpoint;
+  }
 
-    NodeType formula;
+  // block claiming: the worker reserves the next assignments of the shared odometer with one lock acquisition and
+  // enumerates them with its own; a prune jumping past the block moves the shared odometer as well
+  void run_blocks(enumerator_storage_t& store, thread_storage_t& thread_store, int worker, std::chrono::steady_clock::time_point start)
+  {
+    thread_store.pdag_index = store.pdags.size();
+    assignment_block block;
+    std::optional<assignment_block> jump; // jump target after the end of the previous block, as first
+    const auto smallest_block = std::min(std::max<std::size_t>(min_block_size, 1), max_block_size);
+    auto block_size = smallest_block;
+    auto uncontended = 0u; // lock acquisitions in a row without contention
+
+    while (!stop_enumeration) {
+      {
+        std::unique_lock lock(store.ca_mutex, std::try_to_lock);
+        if (!lock.owns_lock()) { // contended: larger blocks
+          block_size = std::min(2 * block_size, max_block_size);
+          uncontended = 0;
+          lock.lock();
+        }
+        else if (++uncontended == uncontended_acquisitions_to_shrink) { // quiet again: smaller blocks
+          block_size = std::max(block_size / 2, smallest_block);
+          uncontended = 0;
+        }
+        if (!claim_block(store, block, block_size, jump)) {
+          store.in_flight[worker].busy = false;
+          enumeration_time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+          return;
+        }
+        store.in_flight[worker] = {true, block.pdag_index, {}, block.first, block.last};
+      }
+      jump.reset();
 
-    if (non_zero_nodes.empty()) { // end node
-      auto map_index = current_assignments[index];
-      auto leaf_node = leaf_nodes.find(map_index);
-      if (leaf_node != leaf_nodes.end()) { // the node was already created
-        formula = leaf_node->second;
+      if (thread_store.pdag_index != block.pdag_index) {
+        thread_store.pdag_index = block.pdag_index;
+        thread_store.pdag = store.pdags[block.pdag_index];
       }
-      else {
-        formula = _symbols[current_assignments[index]].node_constructor(store, {});
-        leaf_nodes.emplace(map_index, formula);
+      auto indices = block.first;
+      auto block_done = false;
+      while (!block_done) {
+        if (stop_enumeration) { // the rest of the block stays in flight
+          std::scoped_lock lock(store.ca_mutex);
+          store.in_flight[worker].block_first = indices;
+          return;
+        }
+
+        thread_store.current_assignment.resize(indices.size());
+        for (auto i = 0ul; i < indices.size(); ++i) {
+          thread_store.current_assignment[i] = store.possible_assignments[block.pdag_index][i][indices[i]];
+        }
+        thread_store.increase_at_position = 0;
+        process_candidate(store, thread_store, start);
+
+        auto position = thread_store.increase_at_position;
+        if (!advance_indices(store, block.pdag_index, indices, position)) {
+          if (position > 0) { // the rest of the DAG is pruned
+            std::scoped_lock lock(store.ca_mutex);
+            if (store.current_pdag == block.pdag_index) {
+              for (auto i = 0ul; i < store.current_assignments[store.current_pdag].size(); ++i) {
+                store.current_assignments[store.current_pdag][i] = std::prev(store.possible_assignments[store.current_pdag][i].cend());
+              }
+            }
+          }
+          block_done = true;
+        }
+        else if (precedes(block.last, indices)) {
+          if (position > 0) {
+            jump = assignment_block{block.pdag_index, indices, {}};
+          }
+          block_done = true;
+        }
+      }
+    }
+
+    std::scoped_lock lock(store.ca_mutex);
+    store.in_flight[worker].busy = false;
+  }
+
+  // called with ca_mutex held, false if there is nothing left to enumerate; as in the other mode the shared odometer
+  // points to the last assignment handed out
+  auto claim_block(enumerator_storage_t& store, assignment_block& block, std::size_t block_size, const std::optional<assignment_block>& jump) -> bool
+  {
+    if (!store.replay.empty()) {
+      block.pdag_index = store.replay.back().first;
+      block.first = to_indices(store, block.pdag_index, store.replay.back().second);
+      block.last = block.first;
+      store.replay.pop_back();
+      return true;
+    }
+    if (store.finished) {
+      return false;
+    }
+
+    if (jump && jump->pdag_index == store.current_pdag && precedes(assignment_indices(store), jump->first)) {
+      for (auto i = 0ul; i < jump->first.size(); ++i) {
+        store.current_assignments[store.current_pdag][i] = store.possible_assignments[store.current_pdag][i].cbegin() + jump->first[i];
+      }
+    }
+    else if (!increase_stack(store)) {
+      if (store.current_pdag + 1 >= static_cast<long>(store.pdags.size())) {
+        store.finished = true;
+        return false;
+      }
+      store.current_pdag++;
+    }
+
+    block.pdag_index = store.current_pdag;
+    block.first = assignment_indices(store);
+    for (auto n = 1ul; n < block_size && !is_last_assignment(store); ++n) {
+      increase_stack(store);
+    }
+    block.last = assignment_indices(store);
+    return true;
+  }
+
+  auto assignment_indices(const enumerator_storage_t& store) const -> std::vector<unsigned>
+  {
+    std::vector<unsigned> indices;
+    for (auto i = 0ul; i < store.current_assignments[store.current_pdag].size(); ++i) {
+      indices.emplace_back(std::distance(store.possible_assignments[store.current_pdag][i].cbegin(), store.current_assignments[store.current_pdag][i]));
+    }
+    return indices;
+  }
+
+  auto is_last_assignment(const enumerator_storage_t& store) const -> bool
+  {
+    for (auto i = 0ul; i < store.current_assignments[store.current_pdag].size(); ++i) {
+      if (std::next(store.current_assignments[store.current_pdag][i]) != store.possible_assignments[store.current_pdag][i].cend()) {
+        return false;
       }
-      sub_components.emplace(index, formula);
     }
-    else if (non_zero_nodes.size() == 1) {
-      auto child = sub_components.find(non_zero_nodes[0] - 1);
-      formula = _symbols[current_assignments[index]].node_constructor(store, {child->second});
-      sub_components.emplace(index, formula);
+    return true;
+  }
+
+  // as increase_stack_at_position on a local odometer, false if it wraps around
+  auto advance_indices(const enumerator_storage_t& store, unsigned pdag_index, std::vector<unsigned>& indices, unsigned position) const -> bool
+  {
+    std::fill(indices.begin(), indices.begin() + position, 0);
+    for (auto i = position; i < indices.size(); ++i) {
+      if (++indices[i] < store.possible_assignments[pdag_index][i].size()) {
+        return true;
+      }
+      indices[i] = 0;
     }
-    else if (non_zero_nodes.size() == 2) {
-      auto child0 = sub_components.find(non_zero_nodes[0] - 1);
-      auto child1 = sub_components.find(non_zero_nodes[1] - 1);
-      formula = _symbols[current_assignments[index]].node_constructor(store, {child0->second, child1->second});
-      sub_components.emplace(index, formula);
+    return false;
+  }
+
+  // enumeration order: the last position is the most significant
+  static auto precedes(const std::vector<unsigned>& a, const std::vector<unsigned>& b) -> bool
+  {
+    return std::lexicographical_compare(a.rbegin(), a.rend(), b.rbegin(), b.rend());
+  }
+
+  auto to_symbols(const enumerator_storage_t& store, unsigned pdag_index, const std::vector<unsigned>& indices) const -> std::vector<int>
+  {
+    std::vector<int> assignment(indices.size());
+    for (auto i = 0ul; i < indices.size(); ++i) {
+      assignment[i] = store.possible_assignments[pdag_index][i][indices[i]];
     }
-    else if (non_zero_nodes.size() == 3) {
-      auto child0 = sub_components.find(non_zero_nodes[0] - 1);
-      auto child1 = sub_components.find(non_zero_nodes[1] - 1);
-      auto child2 = sub_components.find(non_zero_nodes[2] - 1);
-      formula = _symbols[current_assignments[index]].node_constructor(store, {child0->second, child1->second, child2->second});
-      sub_components.emplace(index, formula);
+    return assignment;
+  }
+
+  auto to_indices(const enumerator_storage_t& store, unsigned pdag_index, const std::vector<int>& assignment) const -> std::vector<unsigned>
+  {
+    std::vector<unsigned> indices(assignment.size());
+    for (auto i = 0ul; i < assignment.size(); ++i) {
+      const auto& possible = store.possible_assignments[pdag_index][i];
+      indices[i] = std::distance(possible.begin(), std::find(possible.begin(), possible.end(), static_cast<unsigned>(assignment[i])));
+    }
+    return indices;
+  }
+
+  // the gates of the cone of the vertex, the leaves were created with the network
+  auto create_node(const percy::partial_dag& pdag,
+                   const std::vector<int>& current_assignments,
+                   const std::shared_ptr<EnumerationType>& store,
+                   thread_storage_t& thread_store,
+                   int index) -> NodeType {
+    if (thread_store.network_node_created[index]) { // the element has already been created
+      return thread_store.network_nodes[index];
+    }
+
+    std::array<NodeType, 3> children;
+    auto num_children = 0u;
+    for (auto input : pdag.get_vertex(index)) {
+      if (input == 0) { // ignored input node
+        continue;
+      }
+      if (num_children == children.size()) {
+        throw std::runtime_error("Number of children of this node not supported in to_enumeration_type");
+      }
+      children[num_children++] = create_node(pdag, current_assignments, store, thread_store, input - 1);
+    }
+
+    const auto& symbol = _symbols[current_assignments[index]];
+    NodeType formula;
+    if (num_children == 0) { // end node
+      formula = thread_store.networks.leaves[current_assignments[index]];
+    }
+    else if (num_children == 1) {
+      formula = symbol.node_constructor(store, {children[0]});
+    }
+    else if (num_children == 2) {
+      formula = symbol.node_constructor(store, {children[0], children[1]});
     }
     else {
-      throw std::runtime_error("Number of children of this node not supported in to_enumeration_type");
+      formula = symbol.node_constructor(store, {children[0], children[1], children[2]});
     }
 
+    thread_store.network_nodes[index] = formula;
+    thread_store.network_node_created[index] = true;
     return formula;
   }
 
-  auto to_enumeration_type(const percy::partial_dag& pdag, const std::vector<int>& current_assignments) -> std::shared_ptr<EnumerationType>
+  // the network is taken from the pool of the thread: it is overwritten by a later candidate unless the caller keeps a
+  // reference to it
+  auto to_enumeration_type(const percy::partial_dag& pdag, const std::vector<int>& current_assignments, thread_storage_t& thread_store) -> std::shared_ptr<EnumerationType>
   {
 //    START_CLOCK();
 
-    auto e = _interface->construct_and_return();
-    // the unsigned here represents the index in the vector obtained from get_symbol_types()
-    std::unordered_map<unsigned, NodeType> leaf_nodes;
-    std::unordered_map<unsigned, NodeType> sub_components;
-
     // adding all possible inputs to the network this is needed because otherwise there is no relation between the signal and the position in the TT
-    NodeType formula;
-    for (int i = _symbols.size() - 1; i >= 0; i--) {
-      if (_symbols[i].num_children == 0) { // this is a leaf
-        formula = _symbols[i].node_constructor(e, {});
-        leaf_nodes.emplace(i, formula);
+    auto e = thread_store.networks.acquire([&](const std::shared_ptr<EnumerationType>& empty, std::vector<NodeType>& leaves) {
+      leaves.resize(_symbols.size());
+      for (auto i = 0u; i < _symbols.size(); ++i) { // same order of the inputs as the serial engine and the simulation
+        if (_symbols[i].num_children == 0) { // this is a leaf
+          leaves[i] = _symbols[i].node_constructor(empty, {});
+        }
       }
-    }
+    });
 
-    const auto& node = pdag.get_last_vertex();
-    auto index = pdag.get_last_vertex_index();
-    NodeType head_node = create_node(pdag, current_assignments, e, leaf_nodes, sub_components, node, index);
+    thread_store.network_nodes.resize(pdag.nr_vertices());
+    thread_store.network_node_created.assign(pdag.nr_vertices(), false);
+    NodeType head_node = create_node(pdag, current_assignments, e, thread_store, pdag.get_last_vertex_index());
 
     auto output_constructor = _interface->get_output_constructor();
     output_constructor(e, {head_node});
@@ -335,22 +753,20 @@ protected:
     return e;
   }
 
+  // outside of the workers: a network that is not reused
+  auto to_enumeration_type(const percy::partial_dag& pdag, const std::vector<int>& current_assignments) -> std::shared_ptr<EnumerationType>
+  {
+    thread_storage_t thread_store;
+    return to_enumeration_type(pdag, current_assignments, thread_store);
+  }
+
   auto duplicate_accumulation_check(const enumerator_storage_t& store, thread_storage_t& thread_store) -> bool
   {
 //    START_CLOCK();
 
-    if (store.positions_in_current_assignment[thread_store.pdag_index].empty()) { // the current graph doesn't contain the subgraph
-      return false;
-    }
-
-    for (const auto& positions : store.positions_in_current_assignment[thread_store.pdag_index]) {
-      std::vector<int> current_assignments_view;
-      for (const auto& position : positions) {
-        current_assignments_view.emplace_back(thread_store.current_assignment[position]);
-      }
-
-      auto search = store.duplicated_assignments[thread_store.pdag_index].find(current_assignments_view);
-      if (search != store.duplicated_assignments[thread_store.pdag_index].end()) {
+    for (const auto& [pattern, positions] : store.subgraph_occurrences[thread_store.pdag_index]) {
+      auto key = pack_assignment(pattern, positions.size(), [&](auto i) { return thread_store.current_assignment[positions[i]]; });
+      if (key && store.duplicated_assignments.contains(*key)) {
         thread_store.increase_at_position = positions[0];
 //          ACCUMULATE_TIME(accumulation_check_time);
         return true; // if we reach this we found a duplicated
@@ -361,25 +777,289 @@ protected:
     return false;
   }
 
-  auto duplicate_accumulation(enumerator_storage_t& store, thread_storage_t thread_store, const std::string& duplicate_function)
+  // the pruning of the candidate sets thread_store.increase_at_position
+  void process_candidate(enumerator_storage_t& store, thread_storage_t& thread_store, std::chrono::steady_clock::time_point start)
+  {
+    count_candidate(thread_store);
+    if (!store.pipeline) {
+      if (auto result = evaluate_candidate(store, thread_store)) {
+        accept_result(store, thread_store, *result, start);
+      }
+      return;
+    }
+
+    if (!screen_candidate(store, thread_store)) {
+      return;
+    }
+    if (auto key = pack_assignment(thread_store.pdag_index, thread_store.current_assignment)) {
+      while (!store.pipeline->try_push(*key)) { // the verifiers are behind
+        if (stop_enumeration) {
+          return;
+        }
+        std::this_thread::yield();
+      }
+      return;
+    }
+    if (auto result = verify_candidate(thread_store, simulation_pruning)) { // too large to be packed
+      accept_result(store, thread_store, *result, start);
+    }
+  }
+
+  void accept_result(enumerator_storage_t& store, const thread_storage_t& thread_store, bool accepted, std::chrono::steady_clock::time_point start)
+  {
+    if (accepted) {
+      found_solution(thread_store, start);
+    }
+    duplicate_accumulation(store, thread_store, thread_store.tts[thread_store.pdag.get_last_vertex_index()]);
+  }
+
+  // pipelined mode: runs the callbacks on the candidates of the queue until the producers are done
+  void run_verifier(enumerator_storage_t& store, std::chrono::steady_clock::time_point start)
+  {
+    thread_storage_t thread_store;
+    thread_store.pdag_index = store.pdags.size();
+    while (!stop_enumeration) {
+      auto key = store.pipeline->try_pop();
+      if (!key) {
+        if (!store.producers_done) {
+          std::this_thread::yield();
+          continue;
+        }
+        if (key = store.pipeline->try_pop(); !key) {
+          return;
+        }
+      }
+
+      auto pdag_index = static_cast<unsigned>(*key >> 48u);
+      if (thread_store.pdag_index != pdag_index) {
+        thread_store.pdag_index = pdag_index;
+        thread_store.pdag = store.pdags[pdag_index];
+      }
+      thread_store.current_assignment = unpack_assignment(*key, thread_store.pdag.nr_vertices());
+      if (auto result = verify_candidate(thread_store, false)) {
+        if (*result) {
+          store.verified_solution = true;
+        }
+        accept_result(store, thread_store, *result, start);
+      }
+    }
+  }
+
+  // true if the candidate is accepted, nothing if it is pruned; the function of the candidate is left in root_tt()
+  auto evaluate_candidate(const enumerator_storage_t& store, thread_storage_t& thread_store) -> std::optional<bool>
+  {
+    if (!screen_candidate(store, thread_store)) {
+      return std::nullopt;
+    }
+    return verify_candidate(thread_store, simulation_pruning);
+  }
+
+  // the checks that do not need the callbacks, false if the candidate is pruned
+  auto screen_candidate(const enumerator_storage_t& store, thread_storage_t& thread_store) -> bool
+  {
+    if (formula_is_duplicate(store, thread_store)) {
+      return false;
+    }
+
+    // as in the serial engine the candidate is still processed, the pruning only skips the following ones
+    if (simulation_pruning) {
+      simulate(thread_store);
+      thread_store.increase_at_position = std::max(simulation_pruning_position(store, thread_store), 0);
+    }
+    return true;
+  }
+
+  // the callbacks on a candidate, simulated if it was already
+  auto verify_candidate(thread_storage_t& thread_store, bool simulated) -> std::optional<bool>
+  {
+    if (_use_candidate_callback != nullptr) {
+      if (!simulated) {
+        simulate(thread_store);
+      }
+      return _use_candidate_callback(candidate_view{this, thread_store.pdag, thread_store.current_assignment, thread_store.tts, thread_store.pdag_index, &thread_store});
+    }
+    if (_use_formula_callback != nullptr) {
+      auto ntk = to_enumeration_type(thread_store.pdag, thread_store.current_assignment, thread_store);
+      auto result = _use_formula_callback(this, ntk);
+      if (result.function) {
+        if (thread_store.tts.size() < thread_store.pdag.nr_vertices()) {
+          thread_store.tts.resize(thread_store.pdag.nr_vertices(), truth_table_traits<TruthTable>::construct(_symbols.get_num_terminal_symbols()));
+        }
+        root_tt(thread_store) = std::move(*result.function);
+      }
+      else if (!simulated) {
+        simulate(thread_store);
+      }
+      return result.stop;
+    }
+    return std::nullopt;
+  }
+
+  // the checks of the serial engine (check_inputs, check_same_gate and check_coi) on the simulated TTs: a gate
+  // computing an input or the same function as another gate, or a function with a smaller known realisation than its
+  // cone, is not minimal; the position to increase, -1 if there is none
+  auto simulation_pruning_position(const enumerator_storage_t& store, const thread_storage_t& thread_store) const -> int
+  {
+    const auto& coi_sizes = store.coi_sizes[thread_store.pdag_index];
+    const auto& minimal_indices = store.minimal_indices[thread_store.pdag_index];
+    if (coi_sizes.back() <= 3) {
+      return -1;
+    }
+
+    auto position = -1;
+    for (auto index = 0u; index < coi_sizes.size(); ++index) {
+      if (coi_sizes[index] == 0) {
+        continue;
+      }
+      const auto& tt = thread_store.tts[index];
+      for (auto other = 0u; other < index; ++other) {
+        if (thread_store.tts[other] == tt) {
+          position = std::max(position, coi_sizes[other] == 0 ? minimal_indices[index] : std::min(minimal_indices[index], minimal_indices[other]));
+        }
+      }
+      auto minimal_size = store.minimal_sizes.find(tt);
+      if (minimal_size && static_cast<uint32_t>(coi_sizes[index]) > *minimal_size) {
+        position = std::max(position, minimal_indices[index]);
+      }
+    }
+    return position;
+  }
+
+  static auto root_tt(thread_storage_t& thread_store) -> TruthTable& {
+    return thread_store.tts[thread_store.pdag.get_last_vertex_index()];
+  }
+
+  void copy_minimal_sizes(const enumerator_storage_t& store)
+  {
+    minimal_sizes.clear();
+    store.minimal_sizes.foreach_entry([&](const TruthTable& tt, uint32_t size) {
+      minimal_sizes.emplace(tt, size);
+    });
+  }
+
+  // the key of an assignment in duplicated_assignments: the DAG index in the upper 16 bits, _symbol_bits for each
+  // symbol below, nothing if it does not fit
+  template<typename Symbol>
+  auto pack_assignment(std::size_t pdag_index, std::size_t length, Symbol&& symbol) const -> std::optional<uint64_t>
+  {
+    if (pdag_index >= (1u << 16u) || length * _symbol_bits > 48) {
+      return std::nullopt;
+    }
+    auto key = static_cast<uint64_t>(pdag_index) << 48u;
+    for (auto i = 0ul; i < length; ++i) {
+      key |= static_cast<uint64_t>(symbol(i)) << (i * _symbol_bits);
+    }
+    return key;
+  }
+
+  auto pack_assignment(std::size_t pdag_index, const std::vector<int>& assignment) const -> std::optional<uint64_t>
+  {
+    return pack_assignment(pdag_index, assignment.size(), [&](auto i) { return assignment[i]; });
+  }
+
+  auto unpack_assignment(uint64_t key, std::size_t length) const -> std::vector<int>
+  {
+    std::vector<int> assignment(length);
+    for (auto i = 0ul; i < length; ++i) {
+      assignment[i] = static_cast<int>((key >> (i * _symbol_bits)) & ((1u << _symbol_bits) - 1));
+    }
+    return assignment;
+  }
+
+  // every limits.check_period candidates of the thread: the count is updated and the limits are checked
+  void count_candidate(thread_storage_t& thread_store)
+  {
+    if (++thread_store.unchecked_candidates < limits.period()) {
+      return;
+    }
+    flush_candidates(thread_store);
+    if (auto reason = limits.check(num_candidates)) {
+      request_stop(*reason);
+    }
+  }
+
+  void flush_candidates(thread_storage_t& thread_store)
+  {
+    num_candidates += thread_store.unchecked_candidates;
+    thread_store.unchecked_candidates = 0;
+  }
+
+  // the first reason is kept
+  void request_stop(enumeration_status reason)
+  {
+    auto expected = enumeration_status::running;
+    status.compare_exchange_strong(expected, reason);
+    stop_enumeration = true;
+  }
+
+  void found_solution(const thread_storage_t& thread_store, std::chrono::steady_clock::time_point start)
+  {
+    enumeration_time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    request_stop(enumeration_status::stopped);
+
+    std::stringstream aiger_output;
+//    mockturtle::write_aiger(*ntk, aiger_output);
+    circuit = aiger_output.str();
+    dot = to_dot(thread_store.pdag, thread_store.current_assignment);
+    current_solution = get_current_solution(thread_store.pdag, thread_store.current_assignment);
+    std::cout << current_solution;
+  }
+
+  void initialize_terminal_tts()
+  {
+    _terminal_tts.assign(_symbols.size(), truth_table_traits<TruthTable>::construct(_symbols.get_num_terminal_symbols()));
+    for (auto i = 0u; i < _symbols.size(); ++i) {
+      if (_symbols[i].num_children == 0) {
+        _terminal_tts[i] = _symbols[i].node_operation({});
+      }
+    }
+  }
+
+  // the children of a vertex come before it: the TTs are computed in order, in the buffers of the thread
+  void simulate(thread_storage_t& thread_store)
+  {
+    const auto& vertices = thread_store.pdag.get_vertices();
+    if (thread_store.tts.size() < vertices.size()) {
+      thread_store.tts.resize(vertices.size(), truth_table_traits<TruthTable>::construct(_symbols.get_num_terminal_symbols()));
+    }
+
+    for (auto index = 0u; index < vertices.size(); ++index) {
+      const auto& symbol = _symbols[thread_store.current_assignment[index]];
+      auto& tt = thread_store.tts[index];
+      if (symbol.num_children == 0) {
+        tt = _terminal_tts[thread_store.current_assignment[index]];
+        continue;
+      }
+
+      const auto& node = vertices[index];
+      assert(symbol.num_children == 2 && node[0] > 0 && node[1] > 0);
+      const auto& child0 = thread_store.tts[node[0] - 1];
+      const auto& child1 = thread_store.tts[node[1] - 1];
+      if (symbol.node_operation_inplace) {
+        symbol.node_operation_inplace(&*tt.begin(), {&*child0.cbegin(), &*child1.cbegin()}, tt.num_blocks());
+        tt.mask_bits();
+      }
+      else {
+        tt = symbol.node_operation({child0, child1});
+      }
+    }
+  }
+
+  void duplicate_accumulation(enumerator_storage_t& store, const thread_storage_t& thread_store, const TruthTable& function)
   {
-    auto value = static_cast<unsigned>(std::stoul(duplicate_function, nullptr, 16));
     auto size = std::count_if(thread_store.pdag.get_vertices().begin(), thread_store.pdag.get_vertices().end(), [](const auto& item){
       return !(item[0] == 0 && item[1] == 0); // here we assume a 2 inputs graph
     });
 
-    {
-      std::lock_guard<std::mutex> lock(store.ms_mutex);
-      if (store.minimal_sizes.find(value) == store.minimal_sizes.end()) {
-        store.minimal_sizes.insert({ value, size });
-        return; // found new minimal function -> nothing left to do
+    auto previous_size = store.defer_updates ? deferred_update_min(store, function, size) : store.minimal_sizes.update_min(function, size);
+    if (!previous_size || *previous_size > size) {
+      if (database) {
+        database->insert(function, size, thread_store.pdag_index, thread_store.current_assignment);
       }
+      return; // found new minimal function -> nothing left to do
     }
 
-    // minimal function already in the set
-    assert(store.minimal_sizes.at(value) <= size);
-
-    if (store.minimal_sizes.at(value) == size)
+    if (*previous_size == size)
     {
       return; // the size is equal -> despite being duplicate we do nothing at this stage
       //TODO: manage same size
@@ -388,13 +1068,32 @@ protected:
 //    START_CLOCK();
 
     // minimal function already in the set && the current dag is larger -> duplicate
-    if (store.accumulate[thread_store.pdag_index]) { // just for this specific structure right now
-      store.duplicated_assignments[store.current_pdag].insert(thread_store.current_assignment);
+    if (store.accumulate[thread_store.pdag_index]) {
+      if (store.defer_updates) {
+        store.deferred_duplicates.emplace_back(thread_store.pdag_index, thread_store.current_assignment);
+      }
+      else if (auto key = pack_assignment(thread_store.pdag_index, thread_store.current_assignment)) {
+        store.duplicated_assignments.insert(*key);
+      }
     }
 
 //    ACCUMULATE_TIME(accumulation_time);
   }
 
+  // as concurrent_size_table::update_min, on the sizes of the previous groups and of the current one
+  static auto deferred_update_min(enumerator_storage_t& store, const TruthTable& function, uint32_t size) -> std::optional<uint32_t>
+  {
+    auto previous_size = store.minimal_sizes.find(function);
+    auto it = store.deferred_minimal_sizes.find(function);
+    if (it != store.deferred_minimal_sizes.end()) {
+      previous_size = previous_size ? std::min(*previous_size, it->second) : it->second;
+    }
+    if (!previous_size || size < *previous_size) {
+      store.deferred_minimal_sizes[function] = size;
+    }
+    return previous_size;
+  }
+
   auto formula_is_duplicate(const enumerator_storage_t& store, thread_storage_t & thread_store) -> bool
   {
     bool duplicated = false;
@@ -548,52 +1247,64 @@ protected:
     }
   }
 
-  void initialize(enumerator_storage_t& store) {
-
-    for (int l = 0; l < store.pdags.size(); l++) {
-      auto new_dag = store.pdags[l];
-      int added_elements = 0;
-      int i = 0;
-
-      std::vector<int> added(new_dag.get_vertices().size(), 0);
-      while (i < new_dag.get_vertices().size()) {
-        for (i = added_elements; i < new_dag.get_vertices().size(); ++i) {
-          if (i < added_elements) {
-            continue;
-          }
-          for (int k = 0; k < new_dag.get_vertices()[i].size(); ++k) {
-            if (new_dag.get_vertices()[i][k] == 0) {
-              std::vector<int> new_node(new_dag.get_fanin(), 0);
-              new_dag.get_vertices().insert(new_dag.get_vertices().begin(), new_node);
-              added[i]++;
-              added_elements++;
-              added.emplace_back(0);
-              for (int j = added_elements; j < new_dag.get_vertices().size(); ++j) {
-                for (int z = 0; z < new_dag.get_vertices()[j].size(); ++z) {
-                  if (new_dag.get_vertices()[j][z] > 0) {
-                    new_dag.get_vertices()[j][z]++;
-                  }
+  // a leaf for each missing child of a raw DAG, as partial_dag::add_PI_nodes
+  static void add_PI_nodes(percy::partial_dag& pdag)
+  {
+    auto new_dag = pdag;
+    int added_elements = 0;
+    int i = 0;
+
+    std::vector<int> added(new_dag.get_vertices().size(), 0);
+    while (i < new_dag.get_vertices().size()) {
+      for (i = added_elements; i < new_dag.get_vertices().size(); ++i) {
+        if (i < added_elements) {
+          continue;
+        }
+        for (int k = 0; k < new_dag.get_vertices()[i].size(); ++k) {
+          if (new_dag.get_vertices()[i][k] == 0) {
+            std::vector<int> new_node(new_dag.get_fanin(), 0);
+            new_dag.get_vertices().insert(new_dag.get_vertices().begin(), new_node);
+            added[i]++;
+            added_elements++;
+            added.emplace_back(0);
+            for (int j = added_elements; j < new_dag.get_vertices().size(); ++j) {
+              for (int z = 0; z < new_dag.get_vertices()[j].size(); ++z) {
+                if (new_dag.get_vertices()[j][z] > 0) {
+                  new_dag.get_vertices()[j][z]++;
                 }
               }
-              new_dag.get_vertices()[i + added[i]][k] = 1;
             }
+            new_dag.get_vertices()[i + added[i]][k] = 1;
           }
         }
       }
+    }
 
-      for (int k = new_dag.get_vertices().size() - 1; k >= 0; --k) {
-        if (std::is_sorted(new_dag.get_vertices()[k].begin(), new_dag.get_vertices()[k].end())) {
-          continue;
-        }
-        const auto& child0 = new_dag.get_vertices()[new_dag.get_vertices()[k][0] - 1];
-        const auto& child1 = new_dag.get_vertices()[new_dag.get_vertices()[k][1] - 1];
-        if (!is_leaf_node(child0) || !is_leaf_node(child1)) {
-          continue;
-        }
-        std::swap(new_dag.get_vertices()[k][0], new_dag.get_vertices()[k][1]);
+    for (int k = new_dag.get_vertices().size() - 1; k >= 0; --k) {
+      if (std::is_sorted(new_dag.get_vertices()[k].begin(), new_dag.get_vertices()[k].end())) {
+        continue;
+      }
+      const auto& child0 = new_dag.get_vertices()[new_dag.get_vertices()[k][0] - 1];
+      const auto& child1 = new_dag.get_vertices()[new_dag.get_vertices()[k][1] - 1];
+      if (!is_leaf_node(child0) || !is_leaf_node(child1)) {
+        continue;
       }
+      std::swap(new_dag.get_vertices()[k][0], new_dag.get_vertices()[k][1]);
+    }
+
+    pdag = new_dag;
+  }
 
-      store.pdags[l] = new_dag;
+  void initialize(enumerator_storage_t& store) {
+    _symbol_bits = 1;
+    while ((1u << _symbol_bits) < _symbols.size()) {
+      ++_symbol_bits;
+    }
+
+    for (int l = 0; l < store.pdags.size(); l++) {
+      if (store.pdags[l].nr_PI_vertices == 0) { // the DAGs initialized as generate_dags does already have them
+        add_PI_nodes(store.pdags[l]);
+      }
 
       store.pdags[l].initialize_dfs_sequence();
       store.possible_assignments.emplace_back();
@@ -633,27 +1344,80 @@ protected:
         }
       }
 
-      // initialize duplicate accumulation
-      store.duplicated_assignments.emplace_back();
-      store.positions_in_current_assignment.emplace_back();
+    }
+
+    for (const auto& pdag : store.pdags) {
+      const auto& vertices = pdag.get_vertices();
+      store.coi_sizes.emplace_back();
+      store.minimal_indices.emplace_back();
+      for (auto j = 0u; j < vertices.size(); ++j) {
+        auto in_cone = get_subgraph(vertices, j).second;
+        auto coi_size = 0;
+        for (auto k = 0u; k < vertices.size(); ++k) {
+          coi_size += in_cone[k] && !is_leaf_node(vertices[k]);
+        }
+        store.coi_sizes.back().emplace_back(coi_size);
+        store.minimal_indices.back().emplace_back(std::distance(in_cone.begin(), std::find(in_cone.begin(), in_cone.end(), true)));
+      }
+    }
+
+    mine_subgraph_patterns(store);
+  }
+
+  // duplicate accumulation: the non-minimal assignments of a DAG are pruned from every other DAG that contains it as the
+  // cone of one of its gates, so each DAG of the list is a pattern for the larger ones
+  void mine_subgraph_patterns(enumerator_storage_t& store)
+  {
+    store.subgraph_occurrences.assign(store.pdags.size(), {});
+    store.accumulate.assign(store.pdags.size(), false);
+    if (!subgraph_mining) {
+      return; // no pattern: nothing is accumulated
+    }
+
+    std::map<std::vector<std::vector<int>>, unsigned> patterns; // structure -> index of the DAG
+    for (auto l = 0u; l < store.pdags.size(); ++l) {
+      patterns.emplace(store.pdags[l].get_vertices(), l);
+    }
+
+    for (auto l = 0u; l < store.pdags.size(); ++l) {
       const auto& vertices = store.pdags[l].get_vertices();
-      for (int j = vertices.size() - 2; j >= 0; --j) { // this check doesn't start from the root for now
-        auto result = get_subgraph(vertices, j);
-        if (result.first == subgraphs[1]) {
-          store.positions_in_current_assignment[l].emplace_back();
-
-          for (int k = 0; k < store.current_assignments[l].size(); k++) {
-            if (result.second[k]) {
-              store.positions_in_current_assignment[l].back().emplace_back(k);
-            }
+      for (int j = vertices.size() - 2; j >= 0; --j) { // the cone of the root is the DAG itself
+        if (is_leaf_node(vertices[j])) {
+          continue;
+        }
+        auto [subgraph, in_cone] = get_subgraph(vertices, j);
+        auto it = patterns.find(subgraph);
+        if (it == patterns.end() || !is_fanout_free(vertices, in_cone, j)) {
+          continue;
+        }
+
+        std::vector<int> positions;
+        for (auto k = 0u; k < vertices.size(); ++k) {
+          if (in_cone[k]) {
+            positions.emplace_back(k);
           }
         }
+        store.subgraph_occurrences[l].push_back({it->second, std::move(positions)});
+        store.accumulate[it->second] = true;
+      }
+    }
+  }
+
+  // true if only the root of the cone is used outside of it: otherwise replacing the cone with a smaller structure does
+  // not give a smaller DAG
+  static auto is_fanout_free(const std::vector<std::vector<int>>& vertices, const std::vector<bool>& in_cone, int root) -> bool
+  {
+    for (auto k = 0u; k < vertices.size(); ++k) {
+      if (in_cone[k]) {
+        continue;
       }
-      store.accumulate.emplace_back(false);
-      if (subgraphs[1] == vertices) { // just for this specific structure right now
-        store.accumulate[l] = true;
+      for (auto child : vertices[k]) {
+        if (child > 0 && child - 1 != root && in_cone[child - 1]) {
+          return false;
+        }
       }
     }
+    return true;
   }
 
   auto increase_stack_at_position(enumerator_storage_t& store, unsigned position) -> bool // this function returns true if it was possible to increase the stack
@@ -696,16 +1460,35 @@ protected:
 
 public:
   callback_t _use_formula_callback;
-  const grammar<EnumerationType, NodeType, SymbolType> _symbols;
-  std::shared_ptr<enumeration_interface<EnumerationType, NodeType, SymbolType>> _interface;
+  candidate_callback_t _use_candidate_callback; // if set, used instead of _use_formula_callback
+  std::vector<TruthTable> _terminal_tts; // for each terminal symbol
+  // of minimal_sizes and duplicated_assignments, fixed for a run: once the table is full the duplicates are no longer
+  // accumulated (the pruning is only weaker) and the minimal sizes go to the locked maps
+  std::size_t table_capacity = 1u << 20;
+  uint32_t _symbol_bits = 1;
+  const grammar<EnumerationType, NodeType, SymbolType, TruthTable> _symbols;
+  std::shared_ptr<enumeration_interface<EnumerationType, NodeType, SymbolType, TruthTable>> _interface;
+  std::shared_ptr<minimum_size_database> database; // optional, shared across runs
+  std::string checkpoint_filename;
+  std::chrono::milliseconds checkpoint_interval = std::chrono::minutes(10);
+  // block claiming: with max_block_size > 1 the workers reserve up to max_block_size assignments per lock acquisition,
+  // starting from min_block_size, doubling whenever the lock is contended and halving after
+  // uncontended_acquisitions_to_shrink acquisitions in a row without contention
+  std::size_t min_block_size = 16;
+  std::size_t max_block_size = 1;
+  uint32_t uncontended_acquisitions_to_shrink = 4;
+  // cancellation token, deadline and candidate budget; status tells how the last enumeration ended
+  enumeration_limits limits;
+  std::atomic<enumeration_status> status = enumeration_status::completed;
+  std::atomic<uint64_t> num_candidates = 0; // processed by the last enumeration
+  bool simulation_pruning = true; // see simulation_pruning_position()
+  bool subgraph_mining = true; // see mine_subgraph_patterns()
+  // pipelined mode: with verifier_threads > 0 the callbacks run on their own threads, the enumeration threads hand them
+  // the candidates that pass the pruning through a queue of pipeline_depth entries and wait when it is full
+  int verifier_threads = 0;
+  std::size_t pipeline_depth = 1024;
 
 
-  // duplicate accumulation utilities
-  std::vector<std::vector<std::vector<int>>> subgraphs = {
-                                                          {{0, 0}, {0, 0}, {0, 0}, {2, 3}, {1, 4}},
-                                                          {{0, 0}, {0, 0}, {0, 0}, {0, 0}, {3, 4}, {1, 2}, {5, 6}}
-                                                         };
-
   // parallelization utilities
   std::vector<std::thread> workers;
   std::atomic<bool> stop_enumeration = false;
@@ -716,6 +1499,9 @@ public:
   long accumulation_time = 0;
   struct timespec ts;
 
+  // results
+  std::unordered_map<TruthTable, unsigned, kitty::hash<TruthTable>> minimal_sizes; // as store.minimal_sizes, at the end of the enumeration
+
   // data for JSON
   std::string current_solution;
   long enumeration_time = 0;
@@ -0,0 +1,595 @@
+/* MIT License
+ *
+ * Copyright (c) 2020 Gianluca Martino
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "partial_dag_enumerator_parallel_v2.hpp"
+
+namespace enumeration_tool {
+
+// Parallel engine without the shared odometer: the assignments of a DAG are numbered (slot 0 is the least significant
+// digit) and every worker enumerates a private range of them. A worker without work takes the next task (a DAG or a
+// slice of it, largest first) or steals the upper half of the largest range left, the pruning jumps only move the
+// private position.
+// The DAGs are processed in groups with the same number of gates, one group after the other, so the first size found
+// for a function is still a minimal one.
+template<typename EnumerationType, typename NodeType, typename SymbolType = uint32_t, typename TruthTable = kitty::dynamic_truth_table>
+class partial_dag_enumerator_work_stealing : public partial_dag_enumerator_parallel<EnumerationType, NodeType, SymbolType, TruthTable> {
+public:
+  using base_t = partial_dag_enumerator_parallel<EnumerationType, NodeType, SymbolType, TruthTable>;
+  using enumerator_storage_t = typename base_t::enumerator_storage_t;
+  using thread_storage_t = typename base_t::thread_storage_t;
+
+  using base_t::base_t;
+
+  unsigned tasks_per_worker = 4; // slices of the DAGs for each worker in a group
+
+  // deterministic mode: the candidates, the pruning and the results (accepted candidate, minimal sizes, number of
+  // candidates) are the ones of partial_dag_enumerator in its default order, for any number of workers. The DAGs are
+  // cut in chunks of at least chunk_size assignments, committed in the serial order.
+  // The callback can still be invoked for candidates after the accepted one.
+  bool deterministic = false;
+  uint64_t chunk_size = 4096;
+  std::atomic<unsigned> steals = 0;
+
+protected:
+  // the assignments [next, end) of a DAG, next is moved only by the owner and end only by the thieves
+  struct work_range {
+    std::mutex mutex;
+    unsigned pdag_index = 0;
+    uint64_t next = 0;
+    uint64_t end = 0;
+  };
+
+  // a DAG or a slice of it
+  struct dag_task {
+    unsigned pdag_index;
+    uint64_t begin;
+    uint64_t end;
+  };
+
+  // deterministic mode: the candidates of a chunk that were not pruned, waiting to be committed
+  struct chunk_result {
+    struct candidate {
+      std::vector<int> assignment;
+      TruthTable function;
+      bool accepted;
+    };
+
+    std::vector<candidate> candidates; // the first one of each function and the accepted one
+    uint64_t num_candidates = 0;
+    bool done = false;
+  };
+
+  // deterministic mode: the state of the serial engine, empty at the start of a chunk as in the serial engine
+  struct serial_state {
+    std::vector<bool> valid; // the TT of the vertex is up to date
+    std::unordered_map<TruthTable, int, kitty::hash<TruthTable>> input_ids; // first leaf with the TT
+    std::unordered_map<TruthTable, int, kitty::hash<TruthTable>> gate_ids; // first gate with the TT
+    std::vector<int> inputs;
+  };
+
+  // the cones as seen by the serial engine (partial_dag::get_cois and get_minimal_index), a gate reached by two paths
+  // counts twice in the size
+  struct serial_cones {
+    std::vector<int> sizes;
+    std::vector<int> minimal_indices;
+    std::vector<bool> leaves;
+  };
+
+  void enumerate(enumerator_storage_t& store, int num_workers) override
+  {
+    if (!this->checkpoint_filename.empty()) {
+      throw std::runtime_error("Checkpoints are not supported by the work-stealing engine");
+    }
+    if (this->verifier_threads > 0) {
+      throw std::runtime_error("The pipelined mode is not supported by the work-stealing engine");
+    }
+
+    this->workers.clear();
+    this->stop_enumeration = false;
+    steals = 0;
+    this->initialize_terminal_tts(); // also used by the simulation pruning
+    initialize_weights(store);
+    if (deterministic) {
+      initialize_serial_cones(store);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    // a resumed enumeration: the candidates in flight and the rest of the current DAG come first
+    auto first_dag = static_cast<unsigned>(store.current_pdag);
+    if (store.finished) {
+      return;
+    }
+    auto first_index = uint64_t{ 0 };
+    for (auto i = 0ul; i < store.current_assignments[first_dag].size(); ++i) {
+      first_index += std::distance(store.possible_assignments[first_dag][i].cbegin(), store.current_assignments[first_dag][i]) * _weights[first_dag][i];
+    }
+    if (!store.replay.empty()) {
+      thread_storage_t thread_store;
+      for (auto& [pdag_index, assignment] : store.replay) {
+        thread_store.pdag_index = pdag_index;
+        thread_store.pdag = store.pdags[pdag_index];
+        thread_store.current_assignment = std::move(assignment);
+        this->process_candidate(store, thread_store, start);
+      }
+      store.replay.clear();
+      this->flush_candidates(thread_store);
+    }
+
+    // the pool of workers is kept for all the groups, a group starts once every worker finished the previous one
+    std::vector<work_range> ranges(num_workers);
+    std::vector<dag_task> tasks;
+    std::atomic<unsigned> next_task = 0;
+    std::vector<chunk_result> chunks;
+    std::mutex commit_mutex;
+    auto next_commit = 0ul;
+    store.defer_updates = deterministic;
+    std::mutex pool_mutex;
+    std::condition_variable pool_condition;
+    unsigned group = 0;
+    int idle_workers = 0;
+    bool shutdown = false;
+
+    this->workers.clear();
+    for (int j = 0; j < num_workers; ++j) {
+      this->workers.emplace_back([&, j] {
+        thread_storage_t thread_store;
+        thread_store.pdag_index = std::numeric_limits<unsigned>::max();
+        serial_state serial;
+        auto& own = ranges[j];
+        auto current_group = 0u;
+
+        while (true) {
+          {
+            std::unique_lock lock(pool_mutex);
+            pool_condition.wait(lock, [&] { return shutdown || group != current_group; });
+            if (shutdown) {
+              this->flush_candidates(thread_store);
+              return;
+            }
+            current_group = group;
+          }
+
+          while (deterministic && !this->stop_enumeration) {
+            auto task = next_task++;
+            if (task >= tasks.size()) {
+              break;
+            }
+            run_chunk(store, thread_store, serial, tasks[task], chunks[task]);
+
+            std::scoped_lock lock(commit_mutex);
+            chunks[task].done = true;
+            for (; next_commit < chunks.size() && chunks[next_commit].done && !this->stop_enumeration; ++next_commit) {
+              commit_chunk(store, tasks[next_commit], chunks[next_commit], start);
+            }
+          }
+
+          while (!deterministic && !this->stop_enumeration) {
+            unsigned pdag_index;
+            uint64_t index;
+            {
+              std::scoped_lock lock(own.mutex);
+              pdag_index = own.pdag_index;
+              index = own.next;
+              if (index >= own.end) {
+                pdag_index = std::numeric_limits<unsigned>::max();
+              }
+            }
+            if (pdag_index == std::numeric_limits<unsigned>::max()) {
+              if (!acquire_work(ranges, j, tasks, next_task)) {
+                break;
+              }
+              continue;
+            }
+
+            if (thread_store.pdag_index != pdag_index) { // the DAG is copied once for each range
+              thread_store.pdag_index = pdag_index;
+              thread_store.pdag = store.pdags[pdag_index];
+              thread_store.current_assignment.resize(_weights[pdag_index].size() - 1);
+            }
+            for (auto i = 0ul; i < thread_store.current_assignment.size(); ++i) {
+              thread_store.current_assignment[i] = store.possible_assignments[pdag_index][i][(index / _weights[pdag_index][i]) % store.possible_assignments[pdag_index][i].size()];
+            }
+
+            thread_store.increase_at_position = 0;
+            this->process_candidate(store, thread_store, start);
+
+            // increasing at a position resets the positions below it
+            auto weight = _weights[pdag_index][thread_store.increase_at_position];
+            std::scoped_lock lock(own.mutex);
+            own.next = (index / weight + 1) * weight;
+          }
+
+          {
+            std::scoped_lock lock(pool_mutex);
+            ++idle_workers;
+          }
+          pool_condition.notify_all();
+        }
+      });
+    }
+
+    for (auto group_begin = first_dag; group_begin < store.pdags.size() && !this->stop_enumeration;) {
+      auto group_end = group_begin + 1;
+      while (group_end < store.pdags.size() && nr_gates(store.pdags[group_end]) == nr_gates(store.pdags[group_begin])) {
+        ++group_end;
+      }
+
+      {
+        std::unique_lock lock(pool_mutex);
+        tasks = deterministic ? schedule_chunks(group_begin, group_end, group_begin == first_dag ? first_index : 0) : schedule(group_begin, group_end, group_begin == first_dag ? first_index : 0, num_workers);
+        next_task = 0;
+        chunks.assign(tasks.size(), {});
+        next_commit = 0;
+        for (auto& range : ranges) {
+          range.next = range.end = 0;
+        }
+        idle_workers = 0;
+        ++group;
+        pool_condition.notify_all();
+        pool_condition.wait(lock, [&] { return idle_workers == num_workers; });
+      }
+
+      for (const auto& [function, size] : store.deferred_minimal_sizes) {
+        store.minimal_sizes.update_min(function, size);
+      }
+      store.deferred_minimal_sizes.clear();
+      for (auto& [pdag_index, assignment] : store.deferred_duplicates) {
+        if (auto key = this->pack_assignment(pdag_index, assignment)) {
+          store.duplicated_assignments.insert(*key);
+        }
+      }
+      store.deferred_duplicates.clear();
+
+      group_begin = group_end;
+    }
+
+    {
+      std::scoped_lock lock(pool_mutex);
+      shutdown = true;
+    }
+    pool_condition.notify_all();
+    for (auto& worker : this->workers) {
+      worker.join();
+    }
+
+    if (!this->stop_enumeration) { // otherwise set by found_solution
+      this->enumeration_time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+    if (this->database) {
+      this->database->flush();
+    }
+  }
+
+  // the tasks of a group of DAGs, largest first: the cost of a DAG is its number of assignments, the DAGs larger than
+  // a fair share of the group are sliced
+  auto schedule(unsigned group_begin, unsigned group_end, uint64_t first_index, int num_workers) const -> std::vector<dag_task>
+  {
+    auto group_cost = uint64_t{ 0 };
+    for (auto i = group_begin; i < group_end; ++i) {
+      group_cost += _weights[i].back() - (i == group_begin ? first_index : 0);
+    }
+    auto slice = std::max<uint64_t>(1, group_cost / (static_cast<uint64_t>(num_workers) * tasks_per_worker));
+
+    std::vector<dag_task> tasks;
+    for (auto i = group_begin; i < group_end; ++i) {
+      for (auto begin = i == group_begin ? first_index : 0; begin < _weights[i].back(); begin += slice) {
+        tasks.push_back({i, begin, std::min(begin + slice, _weights[i].back())});
+      }
+    }
+    std::stable_sort(tasks.begin(), tasks.end(), [](const auto& a, const auto& b) {
+      return a.end - a.begin > b.end - b.begin;
+    });
+    return tasks;
+  }
+
+  // the chunks in the serial order, they do not depend on the number of workers. A chunk starts at an assignment
+  // where every leaf changes: the serial engine has no state left from the previous candidates there, and its pruning
+  // (at a position in the cone of a gate, so a leaf) never jumps over it.
+  auto schedule_chunks(unsigned group_begin, unsigned group_end, uint64_t first_index) const -> std::vector<dag_task>
+  {
+    std::vector<dag_task> tasks;
+    for (auto i = group_begin; i < group_end; ++i) {
+      auto last_leaf = 0ul;
+      for (auto index = 0ul; index < _serial_cones[i].leaves.size(); ++index) {
+        if (_serial_cones[i].leaves[index]) {
+          last_leaf = index;
+        }
+      }
+      auto leaves = _weights[i][last_leaf + 1]; // every leaf changes at the multiples
+      auto length = std::max<uint64_t>(1, (chunk_size + leaves - 1) / leaves) * leaves;
+      for (auto begin = i == group_begin ? first_index : 0; begin < _weights[i].back(); begin += length) {
+        tasks.push_back({i, begin, std::min(begin + length, _weights[i].back())});
+      }
+    }
+    return tasks;
+  }
+
+  // the candidates of the chunk as in partial_dag_enumerator::enumerate_pdags; the pruning reads only the sizes
+  // committed by the previous groups, a size of the current group is never smaller than a cone
+  void run_chunk(const enumerator_storage_t& store, thread_storage_t& thread_store, serial_state& serial, const dag_task& task, chunk_result& chunk)
+  {
+    auto pdag_index = task.pdag_index;
+    if (thread_store.pdag_index != pdag_index) {
+      thread_store.pdag_index = pdag_index;
+      thread_store.pdag = store.pdags[pdag_index];
+      thread_store.current_assignment.resize(_weights[pdag_index].size() - 1);
+    }
+    const auto& vertices = thread_store.pdag.get_vertices();
+    const auto& weights = _weights[pdag_index];
+    serial.valid.assign(vertices.size(), false);
+    serial.input_ids.clear();
+    serial.gate_ids.clear();
+    std::unordered_set<TruthTable, kitty::hash<TruthTable>> functions;
+
+    for (auto index = task.begin; index < task.end && !this->stop_enumeration;) {
+      for (auto i = 0ul; i < thread_store.current_assignment.size(); ++i) {
+        thread_store.current_assignment[i] = store.possible_assignments[pdag_index][i][(index / weights[i]) % store.possible_assignments[pdag_index][i].size()];
+      }
+      ++chunk.num_candidates;
+
+      auto position = serial_duplicate_position(thread_store, serial);
+      if (position < 0) {
+        this->simulate(thread_store);
+        position = serial_simulation_position(store, thread_store, serial);
+        auto function = this->root_tt(thread_store);
+        auto accepted = this->verify_candidate(thread_store, true).value_or(false);
+        if (functions.insert(function).second || accepted) {
+          chunk.candidates.push_back({thread_store.current_assignment, std::move(function), accepted});
+        }
+        if (accepted) {
+          break;
+        }
+      }
+
+      // increasing at a position resets the positions below it, every vertex fed by a changed slot is invalidated
+      auto next = (index / weights[std::max(position, 0)] + 1) * weights[std::max(position, 0)];
+      auto slot = static_cast<int>(weights.size()) - 2;
+      while (slot > 0 && index / weights[slot] == next / weights[slot]) {
+        --slot;
+      }
+      for (auto vertex = 0ul; vertex < vertices.size(); ++vertex) {
+        if (serial.valid[vertex] && _serial_cones[pdag_index].minimal_indices[vertex] <= slot) {
+          serial.valid[vertex] = false;
+          (_serial_cones[pdag_index].leaves[vertex] ? serial.input_ids : serial.gate_ids).erase(thread_store.tts[vertex]);
+        }
+      }
+      index = next;
+    }
+  }
+
+  // partial_dag_enumerator::formula_is_duplicate: the leaves of a commutative gate in order, of an idempotent gate all
+  // different
+  auto serial_duplicate_position(const thread_storage_t& thread_store, serial_state& serial) const -> int
+  {
+    const auto& vertices = thread_store.pdag.get_vertices();
+    auto position = -1;
+    for (auto index = static_cast<int>(vertices.size()) - 1; index >= 0; --index) {
+      const auto& symbol = this->_symbols[thread_store.current_assignment[index]];
+      auto commutative = symbol.attributes.is_set(enumeration_attributes::commutative);
+      auto idempotent = symbol.attributes.is_set(enumeration_attributes::idempotent);
+      if (!commutative && !idempotent) {
+        continue;
+      }
+
+      serial.inputs.clear();
+      for (auto input : vertices[index]) {
+        if (input != 0 && _serial_cones[thread_store.pdag_index].leaves[input - 1]) {
+          serial.inputs.emplace_back(thread_store.current_assignment[input - 1]);
+        }
+      }
+      if ((commutative && !std::is_sorted(serial.inputs.begin(), serial.inputs.end())) || (idempotent && !is_unique(serial.inputs))) {
+        position = std::max(position, _serial_cones[thread_store.pdag_index].minimal_indices[index]);
+      }
+    }
+    return position;
+  }
+
+  // partial_dag_enumerator::update_tts on the simulated TTs: the checks are done on the vertices that are not valid,
+  // in the same order
+  auto serial_simulation_position(const enumerator_storage_t& store, const thread_storage_t& thread_store, serial_state& serial) const -> int
+  {
+    const auto& vertices = thread_store.pdag.get_vertices();
+    const auto& cones = _serial_cones[thread_store.pdag_index];
+    auto checked = nr_gates(thread_store.pdag) > 3;
+    auto position = -1;
+
+    std::function<void(int)> update = [&](int index) {
+      for (auto input : vertices[index]) {
+        if (input != 0 && !serial.valid[input - 1]) {
+          update(input - 1);
+        }
+      }
+      serial.valid[index] = true;
+
+      const auto& tt = thread_store.tts[index];
+      if (cones.leaves[index]) {
+        serial.input_ids.emplace(tt, index);
+        return;
+      }
+      if (!checked) {
+        return;
+      }
+      if (serial.input_ids.find(tt) != serial.input_ids.end()) {
+        position = std::max(position, cones.minimal_indices[index]);
+      }
+      if (auto minimal_size = store.minimal_sizes.find(tt); minimal_size && static_cast<uint32_t>(cones.sizes[index]) > *minimal_size) {
+        position = std::max(position, cones.minimal_indices[index]);
+      }
+      if (auto [other, inserted] = serial.gate_ids.emplace(tt, index); !inserted) {
+        position = std::max(position, std::min(cones.minimal_indices[index], cones.minimal_indices[other->second]));
+      }
+    };
+
+    auto root = static_cast<int>(vertices.size()) - 1;
+    if (!serial.valid[root]) {
+      update(root);
+    }
+    return position;
+  }
+
+  // called in the serial order of the chunks, the first accepted candidate stops the enumeration
+  void commit_chunk(enumerator_storage_t& store, const dag_task& task, chunk_result& chunk, std::chrono::steady_clock::time_point start)
+  {
+    this->num_candidates += chunk.num_candidates;
+    thread_storage_t thread_store;
+    thread_store.pdag_index = task.pdag_index;
+    thread_store.pdag = store.pdags[task.pdag_index];
+    for (auto& candidate : chunk.candidates) {
+      thread_store.current_assignment = std::move(candidate.assignment);
+      if (candidate.accepted) {
+        this->found_solution(thread_store, start);
+      }
+      this->duplicate_accumulation(store, thread_store, candidate.function);
+      if (candidate.accepted) {
+        break;
+      }
+    }
+    chunk.candidates.clear();
+    chunk.candidates.shrink_to_fit();
+
+    if (auto reason = this->limits.check(this->num_candidates)) {
+      this->request_stop(*reason);
+    }
+  }
+
+  auto acquire_work(std::vector<work_range>& ranges, int worker, const std::vector<dag_task>& tasks, std::atomic<unsigned>& next_task) -> bool
+  {
+    auto task = next_task++;
+    if (task < tasks.size()) {
+      std::scoped_lock lock(ranges[worker].mutex);
+      ranges[worker].pdag_index = tasks[task].pdag_index;
+      ranges[worker].next = tasks[task].begin;
+      ranges[worker].end = tasks[task].end;
+      return true;
+    }
+
+    while (true) {
+      // the largest range left, the ranges only shrink once the tasks are over
+      auto victim = -1;
+      auto largest = uint64_t{ 1 };
+      for (auto i = 0; i < static_cast<int>(ranges.size()); ++i) {
+        if (i == worker) {
+          continue;
+        }
+        std::scoped_lock lock(ranges[i].mutex);
+        if (ranges[i].end > ranges[i].next && ranges[i].end - ranges[i].next > largest) {
+          largest = ranges[i].end - ranges[i].next;
+          victim = i;
+        }
+      }
+      if (victim < 0) {
+        return false;
+      }
+
+      unsigned stolen_pdag;
+      uint64_t stolen_begin;
+      uint64_t stolen_end;
+      {
+        std::scoped_lock lock(ranges[victim].mutex);
+        if (ranges[victim].end <= ranges[victim].next || ranges[victim].end - ranges[victim].next < 2) {
+          continue; // the owner got there first
+        }
+        stolen_pdag = ranges[victim].pdag_index;
+        stolen_begin = ranges[victim].next + (ranges[victim].end - ranges[victim].next) / 2;
+        stolen_end = ranges[victim].end;
+        ranges[victim].end = stolen_begin;
+      }
+
+      std::scoped_lock lock(ranges[worker].mutex);
+      ranges[worker].pdag_index = stolen_pdag;
+      ranges[worker].next = stolen_begin;
+      ranges[worker].end = stolen_end;
+      ++steals;
+      return true;
+    }
+  }
+
+  // for each DAG the weight of every slot in the numbering, the last one is the number of assignments
+  void initialize_weights(const enumerator_storage_t& store)
+  {
+    _weights.clear();
+    for (const auto& possible_assignments : store.possible_assignments) {
+      _weights.emplace_back(1, 1);
+      for (const auto& assignments : possible_assignments) {
+        if (_weights.back().back() > std::numeric_limits<uint64_t>::max() / assignments.size()) {
+          throw std::runtime_error("Too many assignments for the work-stealing engine");
+        }
+        _weights.back().emplace_back(_weights.back().back() * assignments.size());
+      }
+    }
+  }
+
+  void initialize_serial_cones(const enumerator_storage_t& store)
+  {
+    _serial_cones.clear();
+    for (const auto& pdag : store.pdags) {
+      const auto& vertices = pdag.get_vertices();
+      auto& cones = _serial_cones.emplace_back();
+      std::function<void(int, int&, int&)> visit = [&](int index, int& size, int& minimal_index) {
+        size += !is_leaf_node(vertices[index]);
+        minimal_index = std::min(minimal_index, index);
+        for (auto input : vertices[index]) {
+          if (input != 0) {
+            visit(input - 1, size, minimal_index);
+          }
+        }
+      };
+      for (auto index = 0; index < static_cast<int>(vertices.size()); ++index) {
+        auto size = 0;
+        auto minimal_index = index;
+        visit(index, size, minimal_index);
+        cones.sizes.emplace_back(size);
+        cones.minimal_indices.emplace_back(minimal_index);
+        cones.leaves.push_back(is_leaf_node(vertices[index]));
+      }
+    }
+  }
+
+  static auto nr_gates(const percy::partial_dag& pdag) -> long
+  {
+    return std::count_if(pdag.get_vertices().begin(), pdag.get_vertices().end(), [](const auto& item) {
+      return !(item[0] == 0 && item[1] == 0); // here we assume a 2 inputs graph
+    });
+  }
+
+  std::vector<std::vector<uint64_t>> _weights;
+  std::vector<serial_cones> _serial_cones; // deterministic mode, for each DAG
+};
+
+}
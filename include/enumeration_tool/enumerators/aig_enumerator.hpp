@@ -24,6 +24,10 @@
 #pragma once
 
 #include <enumeration_tool/grammar.hpp>
+#include <enumeration_tool/static_grammar.hpp>
+#include <enumeration_tool/truth_table_kernels.hpp>
+#include <enumeration_tool/utils.hpp>
+#include <kitty/constructors.hpp>
 #include <mockturtle/networks/aig.hpp>
 
 enum EnumerationSymbols
@@ -32,12 +36,17 @@ enum EnumerationSymbols
 };
 
 
-class aig_enumeration_interface : public enumeration_interface<mockturtle::aig_network, mockturtle::aig_network::signal, EnumerationSymbols> {
+template <typename TruthTable = kitty::dynamic_truth_table>
+class aig_enumeration_interface_t : public enumeration_interface<mockturtle::aig_network, mockturtle::aig_network::signal, EnumerationSymbols, TruthTable> {
 public:
   using EnumerationType = mockturtle::aig_network;
   using NodeType = mockturtle::aig_network::signal;
   using SymbolType = EnumerationSymbols;
-  using TruthTable = kitty::dynamic_truth_table;
+  using base_type = enumeration_interface<EnumerationType, NodeType, SymbolType, TruthTable>;
+  using node_constructor_callback_fn = typename base_type::node_constructor_callback_fn;
+  using node_operation_callback_fn = typename base_type::node_operation_callback_fn;
+  using node_operation_inplace_callback_fn = typename base_type::node_operation_inplace_callback_fn;
+  using output_callback_fn = typename base_type::output_callback_fn;
 
   [[nodiscard]]
   auto get_symbol_types() const -> std::vector<SymbolType> override
@@ -128,22 +137,137 @@ public:
 
   auto get_node_operation(SymbolType t) -> node_operation_callback_fn override
   {
-    if (t == False) { return [&, created = false, tt = TruthTable(get_terminal_symbol_types().size())](const std::initializer_list<std::reference_wrapper<const TruthTable>>& tts) mutable -> TruthTable { assert(tts.size() == 0); if (!created) { kitty::create_from_hex_string(tt, create_hex_string(get_terminal_symbol_types().size(), false)); created = true; } return tt; };}
-    if (t == True) { return [&, created = false, tt = TruthTable(get_terminal_symbol_types().size())](const std::initializer_list<std::reference_wrapper<const TruthTable>>& tts) mutable -> TruthTable { assert(tts.size() == 0); if (!created) { kitty::create_from_hex_string(tt, create_hex_string(get_terminal_symbol_types().size(), true)); created = true; } return tt; };}
-    if (t == Not) { return [](const std::initializer_list<std::reference_wrapper<const TruthTable>>& tts) -> TruthTable { assert(tts.size() == 1); return ~(*tts.begin()); };}
-    if (t == And) { return [](const std::initializer_list<std::reference_wrapper<const TruthTable>>& tts) -> TruthTable { assert(tts.size() == 2); return (*tts.begin()) & (*(tts.begin() + 1)); };}
-    if (t == A) { return [&, created = false, tt = TruthTable(get_terminal_symbol_types().size())](const std::initializer_list<std::reference_wrapper<const TruthTable>>& tts) mutable -> TruthTable { assert(tts.size() == 0); if (!created) { kitty::create_from_hex_string(tt, create_hex_string(get_terminal_symbol_types().size(), 0)); created = true; } return tt; };}
-    if (t == B) { return [&, created = false, tt = TruthTable(get_terminal_symbol_types().size())](const std::initializer_list<std::reference_wrapper<const TruthTable>>& tts) mutable -> TruthTable { assert(tts.size() == 0); if (!created) { kitty::create_from_hex_string(tt, create_hex_string(get_terminal_symbol_types().size(), 1)); created = true; } return tt; };}
-    if (t == C) { return [&, created = false, tt = TruthTable(get_terminal_symbol_types().size())](const std::initializer_list<std::reference_wrapper<const TruthTable>>& tts) mutable -> TruthTable { assert(tts.size() == 0); if (!created) { kitty::create_from_hex_string(tt, create_hex_string(get_terminal_symbol_types().size(), 2)); created = true; } return tt; };}
-//    if (t == D) { return [&, created = false, tt = TruthTable(get_terminal_symbol_types().size())](const std::initializer_list<std::reference_wrapper<const TruthTable>>& tts) mutable -> TruthTable { assert(tts.size() == 0); if (!created) { kitty::create_from_hex_string(tt, create_hex_string(get_terminal_symbol_types().size(), 3)); created = true; } return tt; };}
-    if (t == And_F_TT) { return [](const std::initializer_list<std::reference_wrapper<const TruthTable>>& tts) -> TruthTable { assert(tts.size() == 2); return ~((*tts.begin()) & (*(tts.begin() + 1))); };}
-    if (t == And_F_FT) { return [](const std::initializer_list<std::reference_wrapper<const TruthTable>>& tts) -> TruthTable { assert(tts.size() == 2); return ~((~(*tts.begin())) & *(tts.begin() + 1)); };}
-    if (t == And_T_FT) { return [](const std::initializer_list<std::reference_wrapper<const TruthTable>>& tts) -> TruthTable { assert(tts.size() == 2); return ((~(*tts.begin())) & *(tts.begin() + 1)); };}
-    if (t == And_T_FF) { return [](const std::initializer_list<std::reference_wrapper<const TruthTable>>& tts) -> TruthTable { assert(tts.size() == 2); return ((~(*tts.begin())) & (~(*(tts.begin() + 1)))); };}
-    if (t == And_F_TF) { return [](const std::initializer_list<std::reference_wrapper<const TruthTable>>& tts) -> TruthTable { assert(tts.size() == 2); return ~((*tts.begin()) & (~(*(tts.begin() + 1)))); };}
-    if (t == And_T_TF) { return [](const std::initializer_list<std::reference_wrapper<const TruthTable>>& tts) -> TruthTable { assert(tts.size() == 2); return ((*tts.begin()) & (~(*(tts.begin() + 1)))); };}
-    if (t == And_F_FF) { return [](const std::initializer_list<std::reference_wrapper<const TruthTable>>& tts) -> TruthTable { assert(tts.size() == 2); return ~((~(*tts.begin())) & (~(*(tts.begin() + 1)))); };}
+    if (t == False) { return terminal_operation(False); }
+    if (t == True) { return terminal_operation(True); }
+    if (t == Not) { return [](const std::initializer_list<std::reference_wrapper<const TruthTable>>& tts) -> TruthTable { assert(tts.size() == 1); return ~tts.begin()->get(); };}
+    if (t == And) { return [](const std::initializer_list<std::reference_wrapper<const TruthTable>>& tts) -> TruthTable { assert(tts.size() == 2); return tts.begin()->get() & ((tts.begin() + 1)->get()); };}
+    if (t == A) { return terminal_operation(A); }
+    if (t == B) { return terminal_operation(B); }
+    if (t == C) { return terminal_operation(C); }
+//    if (t == D) { return terminal_operation(D); }
+    if (t == And_F_TT) { return [](const std::initializer_list<std::reference_wrapper<const TruthTable>>& tts) -> TruthTable { assert(tts.size() == 2); return ~(tts.begin()->get() & ((tts.begin() + 1)->get())); };}
+    if (t == And_F_FT) { return [](const std::initializer_list<std::reference_wrapper<const TruthTable>>& tts) -> TruthTable { assert(tts.size() == 2); return ~((~tts.begin()->get()) & (tts.begin() + 1)->get()); };}
+    if (t == And_T_FT) { return [](const std::initializer_list<std::reference_wrapper<const TruthTable>>& tts) -> TruthTable { assert(tts.size() == 2); return ((~tts.begin()->get()) & (tts.begin() + 1)->get()); };}
+    if (t == And_T_FF) { return [](const std::initializer_list<std::reference_wrapper<const TruthTable>>& tts) -> TruthTable { assert(tts.size() == 2); return ((~tts.begin()->get()) & (~((tts.begin() + 1)->get()))); };}
+    if (t == And_F_TF) { return [](const std::initializer_list<std::reference_wrapper<const TruthTable>>& tts) -> TruthTable { assert(tts.size() == 2); return ~(tts.begin()->get() & (~((tts.begin() + 1)->get()))); };}
+    if (t == And_T_TF) { return [](const std::initializer_list<std::reference_wrapper<const TruthTable>>& tts) -> TruthTable { assert(tts.size() == 2); return (tts.begin()->get() & (~((tts.begin() + 1)->get()))); };}
+    if (t == And_F_FF) { return [](const std::initializer_list<std::reference_wrapper<const TruthTable>>& tts) -> TruthTable { assert(tts.size() == 2); return ~((~tts.begin()->get()) & (~((tts.begin() + 1)->get()))); };}
     throw std::runtime_error("Unknown NodeType. Where did you get this type?");
   }
 
-};
\ No newline at end of file
+  auto get_node_operation_inplace(SymbolType t) -> node_operation_inplace_callback_fn override
+  {
+    if (t == False) { return terminal_operation_inplace(False); }
+    if (t == True) { return terminal_operation_inplace(True); }
+    if (t == Not) { return [](uint64_t* out, const std::initializer_list<const uint64_t*>& inputs, std::size_t num_words) { assert(inputs.size() == 1); enumeration_tool::kernels::not_words(out, *inputs.begin(), num_words); };}
+    if (t == And) { return [](uint64_t* out, const std::initializer_list<const uint64_t*>& inputs, std::size_t num_words) { assert(inputs.size() == 2); enumeration_tool::kernels::and_words(out, *inputs.begin(), *(inputs.begin() + 1), num_words); };}
+    if (t == A) { return terminal_operation_inplace(A); }
+    if (t == B) { return terminal_operation_inplace(B); }
+    if (t == C) { return terminal_operation_inplace(C); }
+    if (t == And_F_TT) { return [](uint64_t* out, const std::initializer_list<const uint64_t*>& inputs, std::size_t num_words) { assert(inputs.size() == 2); enumeration_tool::kernels::and_words(out, *inputs.begin(), *(inputs.begin() + 1), num_words, false, false, true); };}
+    if (t == And_F_FT) { return [](uint64_t* out, const std::initializer_list<const uint64_t*>& inputs, std::size_t num_words) { assert(inputs.size() == 2); enumeration_tool::kernels::and_words(out, *inputs.begin(), *(inputs.begin() + 1), num_words, true, false, true); };}
+    if (t == And_T_FT) { return [](uint64_t* out, const std::initializer_list<const uint64_t*>& inputs, std::size_t num_words) { assert(inputs.size() == 2); enumeration_tool::kernels::and_words(out, *inputs.begin(), *(inputs.begin() + 1), num_words, true, false, false); };}
+    if (t == And_T_FF) { return [](uint64_t* out, const std::initializer_list<const uint64_t*>& inputs, std::size_t num_words) { assert(inputs.size() == 2); enumeration_tool::kernels::and_words(out, *inputs.begin(), *(inputs.begin() + 1), num_words, true, true, false); };}
+    if (t == And_F_TF) { return [](uint64_t* out, const std::initializer_list<const uint64_t*>& inputs, std::size_t num_words) { assert(inputs.size() == 2); enumeration_tool::kernels::and_words(out, *inputs.begin(), *(inputs.begin() + 1), num_words, false, true, true); };}
+    if (t == And_T_TF) { return [](uint64_t* out, const std::initializer_list<const uint64_t*>& inputs, std::size_t num_words) { assert(inputs.size() == 2); enumeration_tool::kernels::and_words(out, *inputs.begin(), *(inputs.begin() + 1), num_words, false, true, false); };}
+    if (t == And_F_FF) { return [](uint64_t* out, const std::initializer_list<const uint64_t*>& inputs, std::size_t num_words) { assert(inputs.size() == 2); enumeration_tool::kernels::and_words(out, *inputs.begin(), *(inputs.begin() + 1), num_words, true, true, true); };}
+    throw std::runtime_error("Unknown NodeType. Where did you get this type?");
+  }
+
+private:
+  auto num_terminal_vars() const -> uint32_t
+  {
+    return this->get_terminal_symbol_types().size();
+  }
+
+  // the words of a constant or of a projection: the precomputed ones, or computed with kitty and owned by the operation
+  // above max_terminal_vars inputs
+  auto terminal_words(SymbolType t) const -> std::pair<const uint64_t*, std::shared_ptr<const std::vector<uint64_t>>>
+  {
+    const auto num_vars = num_terminal_vars();
+    if (num_vars <= max_terminal_vars) {
+      return { t == False || t == True ? constant_words(num_vars, t == True) : projection_words(num_vars, t - A), nullptr };
+    }
+    kitty::dynamic_truth_table tt(num_vars);
+    if (t == True) {
+      tt = ~tt;
+    }
+    else if (t != False) {
+      kitty::create_nth_var(tt, t - A);
+    }
+    auto owner = std::make_shared<const std::vector<uint64_t>>(tt.cbegin(), tt.cend());
+    return { owner->data(), owner };
+  }
+
+  // the terminals copy their truth table from the precomputed ones
+  auto terminal_operation(SymbolType t) const -> node_operation_callback_fn
+  {
+    auto [words, owner] = terminal_words(t);
+    return [words = words, owner = owner, num_vars = num_terminal_vars()]([[maybe_unused]] const std::initializer_list<std::reference_wrapper<const TruthTable>>& tts) -> TruthTable { assert(tts.size() == 0); auto tt = truth_table_traits<TruthTable>::construct(num_vars); std::copy(words, words + tt.num_blocks(), tt.begin()); return tt; };
+  }
+
+  auto terminal_operation_inplace(SymbolType t) const -> node_operation_inplace_callback_fn
+  {
+    auto [words, owner] = terminal_words(t);
+    return [words = words, owner = owner](uint64_t* out, [[maybe_unused]] const std::initializer_list<const uint64_t*>& inputs, std::size_t num_words) { assert(inputs.size() == 0); std::copy(words, words + num_words, out); };
+  }
+
+};
+
+using aig_enumeration_interface = aig_enumeration_interface_t<>;
+
+// same grammar as aig_enumeration_interface, known at compile time
+struct aig_grammar_description
+{
+  using enumeration_type = mockturtle::aig_network;
+  using node_type = mockturtle::aig_network::signal;
+  using symbol_type = EnumerationSymbols;
+
+  static constexpr enumeration_attributes gate_attributes = {enumeration_attributes::commutative, enumeration_attributes::same_gate_exists, enumeration_attributes::idempotent};
+
+  static constexpr std::array<static_symbol<symbol_type>, 7> symbols = {{
+    {A, 0, true}, {B, 0, true}, {C, 0, true},
+    {And, 2, false, 1, gate_attributes}, {And_T_FT, 2, false, 1, gate_attributes}, {And_T_FF, 2, false, 1, gate_attributes}, {And_T_TF, 2, false, 1, gate_attributes}
+  }};
+
+  static constexpr std::array<symbol_type, 12> root_symbols = { False, And, A, B, C, And_F_TT, And_F_FT, And_T_FT, And_T_FF, And_F_FF, And_F_TF, And_T_TF };
+
+  static void evaluate(symbol_type t, uint64_t* out, const std::initializer_list<const uint64_t*>& inputs, std::size_t num_words)
+  {
+    auto a = inputs.size() > 0 ? *inputs.begin() : nullptr;
+    auto b = inputs.size() > 1 ? *(inputs.begin() + 1) : nullptr;
+    switch (t) {
+      case A: for (auto i = 0ul; i < num_words; ++i) { out[i] = projection_word(0, i); } break;
+      case B: for (auto i = 0ul; i < num_words; ++i) { out[i] = projection_word(1, i); } break;
+      case C: for (auto i = 0ul; i < num_words; ++i) { out[i] = projection_word(2, i); } break;
+      case And: enumeration_tool::kernels::and_words(out, a, b, num_words); break;
+      case And_T_FT: enumeration_tool::kernels::and_words(out, a, b, num_words, true, false, false); break;
+      case And_T_FF: enumeration_tool::kernels::and_words(out, a, b, num_words, true, true, false); break;
+      case And_T_TF: enumeration_tool::kernels::and_words(out, a, b, num_words, false, true, false); break;
+      default: throw std::runtime_error("Unknown NodeType. Where did you get this type?");
+    }
+  }
+
+  static auto construct(symbol_type t, const std::shared_ptr<enumeration_type>& store, const std::initializer_list<node_type>& children) -> node_type
+  {
+    assert(store);
+    switch (t) {
+      case A: return store->create_pi("A");
+      case B: return store->create_pi("B");
+      case C: return store->create_pi("C");
+      case And: return store->create_and(*children.begin(), *(children.begin() + 1));
+      case And_T_FT: return store->create_and(!*children.begin(), *(children.begin() + 1));
+      case And_T_FF: return store->create_and(!*children.begin(), !*(children.begin() + 1));
+      case And_T_TF: return store->create_and(*children.begin(), !*(children.begin() + 1));
+      default: throw std::runtime_error("Unknown NodeType. Where did you get this type?");
+    }
+  }
+
+  static void output(const std::shared_ptr<enumeration_type>& store, const std::vector<node_type>& outputs)
+  {
+    assert(store);
+    for (const auto& output : outputs) {
+      store->create_po(output);
+    }
+  }
+};
@@ -29,10 +29,10 @@
 #include <vector>
 #include <stdexcept>
 
-template <typename EnumerationType, typename NodeType, typename SymbolType = uint32_t>
+template <typename EnumerationType, typename NodeType, typename SymbolType = uint32_t, typename TruthTable = kitty::dynamic_truth_table>
 class grammar
 {
-  using symbol_collection_t = std::vector<enumeration_symbol<EnumerationType, NodeType, SymbolType>>;
+  using symbol_collection_t = std::vector<enumeration_symbol<EnumerationType, NodeType, SymbolType, TruthTable>>;
 
   std::vector<SymbolType> _possible_root_symbols;
   int _nr_terminal_symbols;
@@ -46,7 +46,7 @@ public:
   , _symbols{symbols}
   {}
 
-  const enumeration_symbol<EnumerationType, NodeType, SymbolType>& operator[](std::size_t index) const { return _symbols[index]; }
+  const enumeration_symbol<EnumerationType, NodeType, SymbolType, TruthTable>& operator[](std::size_t index) const { return _symbols[index]; }
 
   [[nodiscard]]
   typename symbol_collection_t::size_type nodes_number() const { return _symbols.size(); }
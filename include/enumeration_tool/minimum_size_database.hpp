@@ -0,0 +1,278 @@
+/* MIT License
+ *
+ * Copyright (c) 2020 Gianluca Martino
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <robin_hood.h>
+
+namespace enumeration_tool {
+
+// Persistent database of minimum sizes: truth table -> minimum number of gates, plus a witness (index of the DAG in the
+// list given to the engine and the assignment of its vertices).
+// The file is memory-mapped read-only and new records are appended by flush(). A later record for the same function
+// overrides the earlier ones if it is smaller. Functions of different numbers of inputs can share the same file.
+// File layout: magic, then records made of a record_header, the words of the truth table and the assignment (padded
+// to 8 bytes).
+class minimum_size_database {
+public:
+  struct record {
+    int32_t size;
+    int32_t dag_index;
+    std::vector<int> assignment;
+  };
+
+  explicit minimum_size_database(std::string filename)
+    : _filename{ std::move(filename) }
+  {
+    map();
+  }
+
+  ~minimum_size_database()
+  {
+    try {
+      flush();
+    } catch (const std::runtime_error&) {} // the pending records are lost
+    unmap();
+  }
+
+  minimum_size_database(const minimum_size_database&) = delete;
+  auto operator=(const minimum_size_database&) -> minimum_size_database& = delete;
+
+  static constexpr auto num_words(uint32_t num_vars) -> std::size_t { return num_vars <= 6 ? 1 : std::size_t(1) << (num_vars - 6); }
+
+  [[nodiscard]]
+  auto size() const -> std::size_t {
+    std::scoped_lock lock(_mutex);
+    auto result = _index.size();
+    for (const auto& [key, value] : _pending) {
+      result += _index.contains(key) ? 0 : 1;
+    }
+    return result;
+  }
+
+  [[nodiscard]]
+  auto find(uint32_t num_vars, const uint64_t* words) const -> std::optional<record> {
+    std::scoped_lock lock(_mutex);
+    auto key = make_key(num_vars, words);
+    if (auto it = _pending.find(key); it != _pending.end()) {
+      return it->second;
+    }
+    if (auto it = _index.find(key); it != _index.end()) {
+      return read_record(it->second);
+    }
+    return std::nullopt;
+  }
+
+  template<typename TruthTable>
+  [[nodiscard]]
+  auto find(const TruthTable& tt) const -> std::optional<record> {
+    return find(tt.num_vars(), &*tt.cbegin());
+  }
+
+  // returns true if the function was not in the database or if it was with a larger size
+  auto insert(uint32_t num_vars, const uint64_t* words, int32_t size, int32_t dag_index, const std::vector<int>& assignment) -> bool {
+    std::scoped_lock lock(_mutex);
+    auto key = make_key(num_vars, words);
+    if (auto it = _pending.find(key); it != _pending.end()) {
+      if (it->second.size <= size) {
+        return false;
+      }
+    }
+    else if (auto it_index = _index.find(key); it_index != _index.end()) {
+      if (read_header(it_index->second).size <= size) {
+        return false;
+      }
+    }
+    _pending[key] = record{size, dag_index, assignment};
+    return true;
+  }
+
+  template<typename TruthTable>
+  auto insert(const TruthTable& tt, int32_t size, int32_t dag_index, const std::vector<int>& assignment) -> bool {
+    return insert(tt.num_vars(), &*tt.cbegin(), size, dag_index, assignment);
+  }
+
+  // fn(const uint64_t* words, int32_t size) for every function of num_vars inputs
+  template<typename Fn>
+  void foreach_entry(uint32_t num_vars, Fn&& fn) const {
+    std::scoped_lock lock(_mutex);
+    for (const auto& [key, offset] : _index) {
+      if (key[0] == num_vars && !_pending.contains(key)) {
+        fn(key.data() + 1, read_header(offset).size);
+      }
+    }
+    for (const auto& [key, value] : _pending) {
+      if (key[0] == num_vars) {
+        fn(key.data() + 1, value.size);
+      }
+    }
+  }
+
+  // appends the pending records to the file
+  void flush() {
+    std::scoped_lock lock(_mutex);
+    if (_pending.empty()) {
+      return;
+    }
+
+    auto file = std::fopen(_filename.c_str(), "ab");
+    if (file == nullptr) {
+      throw std::runtime_error("Cannot open the minimum size database " + _filename);
+    }
+    if (_length == 0) {
+      std::fwrite(magic, sizeof(magic), 1, file);
+    }
+    for (const auto& [key, value] : _pending) {
+      record_header header{static_cast<uint32_t>(key[0]), value.size, value.dag_index, static_cast<uint32_t>(value.assignment.size())};
+      std::vector<int32_t> assignment(value.assignment.begin(), value.assignment.end());
+      assignment.resize(((assignment.size() + 1) / 2) * 2, 0); // padding
+      std::fwrite(&header, sizeof(header), 1, file);
+      std::fwrite(key.data() + 1, sizeof(uint64_t), key.size() - 1, file);
+      std::fwrite(assignment.data(), sizeof(int32_t), assignment.size(), file);
+    }
+    if (std::fclose(file) != 0) {
+      throw std::runtime_error("Cannot write the minimum size database " + _filename);
+    }
+
+    _pending.clear();
+    unmap();
+    map();
+  }
+
+protected:
+  struct record_header {
+    uint32_t num_vars;
+    int32_t size;
+    int32_t dag_index;
+    uint32_t assignment_size;
+  };
+
+  struct key_hash {
+    auto operator()(const std::vector<uint64_t>& key) const -> std::size_t {
+      return robin_hood::hash_bytes(key.data(), key.size() * sizeof(uint64_t));
+    }
+  };
+
+  static constexpr char magic[8] = {'E', 'T', 'M', 'S', 'D', 'B', '0', '1'};
+
+  static auto make_key(uint32_t num_vars, const uint64_t* words) -> std::vector<uint64_t> {
+    std::vector<uint64_t> key(num_words(num_vars) + 1);
+    key[0] = num_vars;
+    std::copy(words, words + num_words(num_vars), key.begin() + 1);
+    return key;
+  }
+
+  auto read_header(std::size_t offset) const -> record_header {
+    record_header header;
+    std::memcpy(&header, _data + offset, sizeof(header));
+    return header;
+  }
+
+  auto read_record(std::size_t offset) const -> record {
+    auto header = read_header(offset);
+    std::vector<int32_t> assignment(header.assignment_size);
+    std::memcpy(assignment.data(), _data + offset + sizeof(header) + num_words(header.num_vars) * sizeof(uint64_t), header.assignment_size * sizeof(int32_t));
+    return {header.size, header.dag_index, std::vector<int>(assignment.begin(), assignment.end())};
+  }
+
+  void map() {
+    auto fd = ::open(_filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+      return; // no database yet
+    }
+    struct stat file_stat;
+    if (::fstat(fd, &file_stat) != 0) {
+      ::close(fd);
+      throw std::runtime_error("Cannot read the minimum size database " + _filename);
+    }
+    _length = static_cast<std::size_t>(file_stat.st_size);
+    if (_length == 0) {
+      ::close(fd);
+      return;
+    }
+    auto data = ::mmap(nullptr, _length, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) {
+      _length = 0;
+      throw std::runtime_error("Cannot map the minimum size database " + _filename);
+    }
+    _data = static_cast<const char*>(data);
+
+    if (_length < sizeof(magic) || std::memcmp(_data, magic, sizeof(magic)) != 0) {
+      unmap();
+      throw std::runtime_error("Not a minimum size database: " + _filename);
+    }
+
+    // index of the records, the smallest size wins
+    std::size_t offset = sizeof(magic);
+    while (offset + sizeof(record_header) <= _length) {
+      auto header = read_header(offset);
+      auto words = reinterpret_cast<const uint64_t*>(_data + offset + sizeof(record_header));
+      auto length = sizeof(record_header) + num_words(header.num_vars) * sizeof(uint64_t) + ((header.assignment_size + 1) / 2) * 2 * sizeof(int32_t);
+      if (offset + length > _length) {
+        break; // truncated record
+      }
+      auto key = make_key(header.num_vars, words);
+      auto it = _index.find(key);
+      if (it == _index.end()) {
+        _index.emplace(std::move(key), offset);
+      }
+      else if (read_header(it->second).size > header.size) {
+        it->second = offset;
+      }
+      offset += length;
+    }
+  }
+
+  void unmap() {
+    if (_data != nullptr) {
+      ::munmap(const_cast<char*>(_data), _length);
+    }
+    _data = nullptr;
+    _length = 0;
+    _index.clear();
+  }
+
+  std::string _filename;
+  const char* _data = nullptr;
+  std::size_t _length = 0;
+  robin_hood::unordered_flat_map<std::vector<uint64_t>, std::size_t, key_hash> _index; // value: offset of the record in the file
+  robin_hood::unordered_node_map<std::vector<uint64_t>, record, key_hash> _pending; // records not yet in the file
+  mutable std::mutex _mutex;
+};
+
+}
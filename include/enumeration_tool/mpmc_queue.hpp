@@ -0,0 +1,118 @@
+/* MIT License
+ *
+ * Copyright (c) 2020 Gianluca Martino
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+
+namespace enumeration_tool {
+
+// Bounded queue for several producers and consumers: a ring of cells with a sequence number each (Vyukov's scheme), no
+// locks and no allocation after the construction. The capacity is rounded up to a power of two; try_push() fails when
+// the queue is full, it is up to the producers to wait.
+template<typename T>
+class mpmc_queue {
+public:
+  explicit mpmc_queue(std::size_t capacity = 1024)
+  {
+    _capacity = 2;
+    while (_capacity < capacity) {
+      _capacity <<= 1u;
+    }
+    _cells = std::make_unique<cell[]>(_capacity);
+    for (auto i = 0ul; i < _capacity; ++i) {
+      _cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  mpmc_queue(const mpmc_queue&) = delete;
+  auto operator=(const mpmc_queue&) -> mpmc_queue& = delete;
+
+  auto try_push(const T& value) -> bool
+  {
+    auto position = _enqueue_position.load(std::memory_order_relaxed);
+    while (true) {
+      auto& c = _cells[position & (_capacity - 1)];
+      auto sequence = c.sequence.load(std::memory_order_acquire);
+      auto difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+      if (difference == 0) {
+        if (_enqueue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+          c.value = value;
+          c.sequence.store(position + 1, std::memory_order_release);
+          return true;
+        }
+      }
+      else if (difference < 0) { // full
+        return false;
+      }
+      else {
+        position = _enqueue_position.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  auto try_pop() -> std::optional<T>
+  {
+    auto position = _dequeue_position.load(std::memory_order_relaxed);
+    while (true) {
+      auto& c = _cells[position & (_capacity - 1)];
+      auto sequence = c.sequence.load(std::memory_order_acquire);
+      auto difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position + 1);
+      if (difference == 0) {
+        if (_dequeue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+          T value = std::move(c.value);
+          c.sequence.store(position + _capacity, std::memory_order_release);
+          return value;
+        }
+      }
+      else if (difference < 0) { // empty
+        return std::nullopt;
+      }
+      else {
+        position = _dequeue_position.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  [[nodiscard]]
+  auto capacity() const -> std::size_t
+  {
+    return _capacity;
+  }
+
+protected:
+  struct cell {
+    std::atomic<std::size_t> sequence;
+    T value;
+  };
+
+  std::size_t _capacity;
+  std::unique_ptr<cell[]> _cells;
+  alignas(64) std::atomic<std::size_t> _enqueue_position{ 0 };
+  alignas(64) std::atomic<std::size_t> _dequeue_position{ 0 };
+};
+
+}
@@ -0,0 +1,108 @@
+/* MIT License
+ *
+ * Copyright (c) 2020 Gianluca Martino
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace enumeration_tool {
+
+namespace detail {
+
+// mockturtle networks: the copies of a network share its storage
+template <typename Network, typename = void>
+struct has_shared_storage : std::false_type {};
+
+template <typename Network>
+struct has_shared_storage<Network, std::void_t<decltype(*std::declval<Network&>()._storage = *std::declval<const Network&>()._storage)>> : std::true_type {};
+
+template <typename Network, typename = void>
+struct storage_of { using type = int; };
+
+template <typename Network>
+struct storage_of<Network, std::enable_if_t<has_shared_storage<Network>::value>> {
+  using type = std::decay_t<decltype(*std::declval<Network&>()._storage)>;
+};
+
+} // namespace detail
+
+// Networks for to_enumeration_type(), one pool for each thread of an engine. A network is created once with the primary
+// inputs and then restored to that state for the next candidates: the vectors of its storage keep their capacity. A
+// network still referenced from outside (a callback kept the pointer or a copy of the network) is left to its owner and
+// the pool creates another one. Networks without a mockturtle storage are created for every candidate.
+template <typename EnumerationType, typename NodeType>
+class network_pool {
+public:
+  explicit network_pool(std::size_t max_networks = 2)
+    : _max_networks{ max_networks }
+  {}
+
+  // a network with only the primary inputs: create_inputs(network, leaves) adds them to an empty network and sets the
+  // signals in leaves, the pool keeps them for the networks it restores
+  template <typename Fn>
+  auto acquire(Fn&& create_inputs) -> std::shared_ptr<EnumerationType>
+  {
+    if constexpr (detail::has_shared_storage<EnumerationType>::value) {
+      for (auto& network : _networks) {
+        if (network.use_count() == 1 && network->_storage.use_count() == 1) {
+          *network->_storage = *_inputs_only;
+          return network;
+        }
+      }
+    }
+
+    auto network = std::make_shared<EnumerationType>();
+    create_inputs(network, leaves);
+    ++num_created;
+    if constexpr (detail::has_shared_storage<EnumerationType>::value) {
+      if (!_inputs_only) {
+        _inputs_only.emplace(*network->_storage);
+      }
+      if (_networks.size() < _max_networks) {
+        _networks.push_back(network);
+      }
+      else { // all of them are in use: the oldest one is given up
+        _networks[_next_replaced] = network;
+        _next_replaced = (_next_replaced + 1) % _max_networks;
+      }
+    }
+    return network;
+  }
+
+  std::vector<NodeType> leaves; // the signal of each terminal symbol, indexed by symbol
+  std::size_t num_created = 0;
+
+private:
+  std::size_t _max_networks;
+  std::size_t _next_replaced = 0;
+  std::vector<std::shared_ptr<EnumerationType>> _networks;
+  std::optional<typename detail::storage_of<EnumerationType>::type> _inputs_only; // the storage right after create_inputs
+};
+
+} // namespace enumeration_tool
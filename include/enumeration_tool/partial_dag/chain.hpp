@@ -8,6 +8,7 @@
 #include "dag.hpp"
 #include "spec.hpp"
 #include "misc.hpp"
+#include "../truth_table_kernels.hpp"
 
 /*******************************************************************************
     Definition of Boolean chain. A Boolean chain is a sequence of steps. Each
@@ -328,19 +329,24 @@ namespace percy
                         }
                     }
 
-                    kitty::clear(tt_step);
-                    for (int j = 0; j < op_tt_size; j++) {
-                        kitty::clear(tt_compute);
-                        tt_compute = ~tt_compute;
-                        if (get_bit(operators[i], j)) {
-                            for (int k = 0; k < fanin; k++) {
-                                if ((j >> k) & 1) {
-                                    tt_compute &= ins[k];
-                                } else {
-                                    tt_compute &= ~ins[k];
+                    if (fanin == 2) { // a single pass over the words instead of one for each minterm
+                        enumeration_tool::kernels::binary_function_words(&*tt_step.begin(), &*ins[0].cbegin(), &*ins[1].cbegin(), tt_step.num_blocks(), static_cast<unsigned>(*operators[i].cbegin()));
+                        tt_step.mask_bits();
+                    } else {
+                        kitty::clear(tt_step);
+                        for (int j = 0; j < op_tt_size; j++) {
+                            kitty::clear(tt_compute);
+                            tt_compute = ~tt_compute;
+                            if (get_bit(operators[i], j)) {
+                                for (int k = 0; k < fanin; k++) {
+                                    if ((j >> k) & 1) {
+                                        tt_compute &= ins[k];
+                                    } else {
+                                        tt_compute &= ~ins[k];
+                                    }
                                 }
+                                tt_step |= tt_compute;
                             }
-                            tt_step |= tt_compute;
                         }
                     }
                     tmps[i] = tt_step;
@@ -0,0 +1,161 @@
+/* MIT License
+ *
+ * Copyright (c) 2020 Gianluca Martino
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include <kitty/dynamic_truth_table.hpp>
+
+#include "grammar.hpp"
+#include "symbol.hpp"
+#include "truth_table_traits.hpp"
+
+// A grammar known at compile time. A description is a struct providing:
+//   using enumeration_type = ...; using node_type = ...; using symbol_type = ...;
+//   static constexpr std::array<static_symbol<symbol_type>, N> symbols = {...};
+//   static constexpr std::array<symbol_type, M> root_symbols = {...};
+//   static void evaluate(symbol_type t, uint64_t* out, const std::initializer_list<const uint64_t*>& inputs, std::size_t num_words);
+//   static auto construct(symbol_type t, const std::shared_ptr<enumeration_type>& store, const std::initializer_list<node_type>& children) -> node_type;
+//   static void output(const std::shared_ptr<enumeration_type>& store, const std::vector<node_type>& outputs);
+// evaluate and construct are expected to be a switch over the symbol type: an engine instantiated over the description
+// calls them directly (see the GrammarDescription parameter of partial_dag_enumerator), static_enumeration_interface
+// exposes the same description through the runtime grammar.
+template <typename SymbolType>
+struct static_symbol
+{
+  SymbolType type;
+  uint32_t num_children = 0;
+  bool terminal_symbol = false;
+  int32_t cost = 1;
+  enumeration_attributes attributes = {};
+};
+
+template <typename Description>
+constexpr auto find_static_symbol(typename Description::symbol_type t) -> const static_symbol<typename Description::symbol_type>&
+{
+  for (const auto& symbol : Description::symbols) {
+    if (symbol.type == t) {
+      return symbol;
+    }
+  }
+  throw std::runtime_error("Unknown NodeType. Where did you get this type?");
+}
+
+template <typename Description>
+constexpr auto num_static_terminal_symbols() -> uint32_t
+{
+  uint32_t result = 0;
+  for (const auto& symbol : Description::symbols) {
+    result += symbol.terminal_symbol ? 1 : 0;
+  }
+  return result;
+}
+
+template <typename Description, typename TruthTable = kitty::dynamic_truth_table>
+class static_enumeration_interface : public enumeration_interface<typename Description::enumeration_type, typename Description::node_type, typename Description::symbol_type, TruthTable> {
+public:
+  using EnumerationType = typename Description::enumeration_type;
+  using NodeType = typename Description::node_type;
+  using SymbolType = typename Description::symbol_type;
+  using base_type = enumeration_interface<EnumerationType, NodeType, SymbolType, TruthTable>;
+  using node_constructor_callback_fn = typename base_type::node_constructor_callback_fn;
+  using node_operation_callback_fn = typename base_type::node_operation_callback_fn;
+  using node_operation_inplace_callback_fn = typename base_type::node_operation_inplace_callback_fn;
+  using output_callback_fn = typename base_type::output_callback_fn;
+
+  [[nodiscard]]
+  auto get_symbol_types() const -> std::vector<SymbolType> override
+  {
+    std::vector<SymbolType> result;
+    for (const auto& symbol : Description::symbols) {
+      result.emplace_back(symbol.type);
+    }
+    return result;
+  }
+
+  [[nodiscard]]
+  auto get_terminal_symbol_types() const -> std::vector<SymbolType> override
+  {
+    std::vector<SymbolType> result;
+    for (const auto& symbol : Description::symbols) {
+      if (symbol.terminal_symbol) {
+        result.emplace_back(symbol.type);
+      }
+    }
+    return result;
+  }
+
+  [[nodiscard]]
+  auto get_possible_children(SymbolType) const -> std::vector<SymbolType> override { return {}; } // not used by the partial DAG engines
+
+  [[nodiscard]]
+  auto get_possible_roots_types() const -> std::vector<SymbolType> override
+  {
+    return std::vector<SymbolType>(Description::root_symbols.begin(), Description::root_symbols.end());
+  }
+
+  [[nodiscard]]
+  uint32_t get_num_children(SymbolType t) const override { return find_static_symbol<Description>(t).num_children; }
+
+  [[nodiscard]]
+  int32_t get_node_cost(SymbolType t) const override { return find_static_symbol<Description>(t).cost; }
+
+  auto get_enumeration_attributes(SymbolType t) -> enumeration_attributes override { return find_static_symbol<Description>(t).attributes; }
+
+  auto get_node_constructor(SymbolType t) -> node_constructor_callback_fn override
+  {
+    return [t](const std::shared_ptr<EnumerationType>& store, const std::initializer_list<NodeType>& children) -> NodeType { return Description::construct(t, store, children); };
+  }
+
+  auto get_output_constructor() -> output_callback_fn override
+  {
+    return [](const std::shared_ptr<EnumerationType>& store, const std::vector<NodeType>& outputs) { Description::output(store, outputs); };
+  }
+
+  auto get_node_operation(SymbolType t) -> node_operation_callback_fn override
+  {
+    return [t](const std::initializer_list<std::reference_wrapper<const TruthTable>>& tts) -> TruthTable {
+      auto tt = truth_table_traits<TruthTable>::construct(num_static_terminal_symbols<Description>());
+      auto input = [&](std::size_t i) { return &*(tts.begin() + i)->get().cbegin(); };
+      switch (tts.size()) {
+        case 0: Description::evaluate(t, &*tt.begin(), {}, tt.num_blocks()); break;
+        case 1: Description::evaluate(t, &*tt.begin(), {input(0)}, tt.num_blocks()); break;
+        case 2: Description::evaluate(t, &*tt.begin(), {input(0), input(1)}, tt.num_blocks()); break;
+        case 3: Description::evaluate(t, &*tt.begin(), {input(0), input(1), input(2)}, tt.num_blocks()); break;
+        default: throw std::runtime_error("Number of children of this node not supported in get_node_operation");
+      }
+      tt.mask_bits();
+      return tt;
+    };
+  }
+
+  auto get_node_operation_inplace(SymbolType t) -> node_operation_inplace_callback_fn override
+  {
+    return [t](uint64_t* out, const std::initializer_list<const uint64_t*>& inputs, std::size_t num_words) { Description::evaluate(t, out, inputs, num_words); };
+  }
+};
@@ -33,10 +33,12 @@
 
 #include <kitty/dynamic_truth_table.hpp>
 
-template <typename EnumerationType, typename NodeType, typename SymbolType>
+#include "truth_table_traits.hpp"
+
+template <typename EnumerationType, typename NodeType, typename SymbolType, typename TruthTable>
 class grammar;
 
-template <typename EnumerationType, typename NodeType, typename SymbolType>
+template <typename EnumerationType, typename NodeType, typename SymbolType, typename TruthTable>
 class enumeration_interface;
 
 class enumeration_attributes {
@@ -55,23 +57,23 @@ public:
     associativite         = 1 << 9
   };
 
-  enumeration_attributes() {
+  constexpr enumeration_attributes() {
     set(no);
   }
 
-  enumeration_attributes(std::initializer_list<EnumerationAttributeEnum> l) {
+  constexpr enumeration_attributes(std::initializer_list<EnumerationAttributeEnum> l) {
     for (const auto& item : l) {
       set(item);
     }
   }
 
   [[nodiscard]]
-  bool is_set(EnumerationAttributeEnum flag) const {
+  constexpr bool is_set(EnumerationAttributeEnum flag) const {
 //    auto value = attributes & flag;
     return ( ( attributes & flag ) == flag );
   }
 
-  void set(EnumerationAttributeEnum attr) {
+  constexpr void set(EnumerationAttributeEnum attr) {
     attributes = attributes | uint32_t(attr);
   }
 
@@ -79,11 +81,12 @@ protected:
   uint32_t attributes = 0;
 };
 
-template <typename EnumerationType, typename NodeType, typename SymbolType = uint32_t>
+template <typename EnumerationType, typename NodeType, typename SymbolType = uint32_t, typename TruthTable = kitty::dynamic_truth_table>
 class enumeration_symbol { // this is the node
 public:
   using node_constructor_callback_fn = std::function<NodeType(const std::shared_ptr<EnumerationType>&, const std::initializer_list<NodeType>&)>;
-  using node_operation_callback_fn = std::function<kitty::dynamic_truth_table(const std::initializer_list<std::reference_wrapper<const kitty::dynamic_truth_table>>&)>;
+  using node_operation_callback_fn = std::function<TruthTable(const std::initializer_list<std::reference_wrapper<const TruthTable>>&)>;
+  using node_operation_inplace_callback_fn = std::function<void(uint64_t*, const std::initializer_list<const uint64_t*>&, std::size_t)>;
 
   bool terminal_symbol = false;
   SymbolType type;
@@ -93,16 +96,19 @@ public:
   enumeration_attributes attributes;
   node_constructor_callback_fn node_constructor;
   node_operation_callback_fn node_operation;
+  node_operation_inplace_callback_fn node_operation_inplace; // optional, preferred for simulation if set
 
 };
 
-template <typename EnumerationType, typename NodeType, typename SymbolType = uint32_t>
+template <typename EnumerationType, typename NodeType, typename SymbolType = uint32_t, typename TruthTable = kitty::dynamic_truth_table>
 class enumeration_interface {
 public:
   std::shared_ptr<EnumerationType> _shared_object_store;
 
   using node_constructor_callback_fn = std::function<NodeType(const std::shared_ptr<EnumerationType>&, const std::initializer_list<NodeType>&)>;
-  using node_operation_callback_fn = std::function<kitty::dynamic_truth_table(const std::initializer_list<std::reference_wrapper<const kitty::dynamic_truth_table>>&)>;
+  using node_operation_callback_fn = std::function<TruthTable(const std::initializer_list<std::reference_wrapper<const TruthTable>>&)>;
+  // writes num_words words of the result in the output buffer, reading num_words words from each input
+  using node_operation_inplace_callback_fn = std::function<void(uint64_t*, const std::initializer_list<const uint64_t*>&, std::size_t)>;
   using output_callback_fn = std::function<void(const std::shared_ptr<EnumerationType>&, const std::vector<NodeType>&)>;
 
   virtual auto get_symbol_types() const -> std::vector<SymbolType> = 0;
@@ -117,6 +123,7 @@ public:
   virtual auto symbol_type_to_string(SymbolType) -> std::string { return ""; }
   // needed for simulation
   virtual auto get_node_operation(SymbolType t) -> node_operation_callback_fn = 0;
+  virtual auto get_node_operation_inplace(SymbolType) -> node_operation_inplace_callback_fn { return nullptr; }
 
   void construct()
   {
@@ -128,21 +135,22 @@ public:
     return std::make_shared<EnumerationType>();
   }
 
-  auto build_grammar() -> grammar<EnumerationType, NodeType, SymbolType>
+  auto build_grammar() -> grammar<EnumerationType, NodeType, SymbolType, TruthTable>
   {
-    std::vector<enumeration_symbol<EnumerationType, NodeType, SymbolType>> symbols;
+    std::vector<enumeration_symbol<EnumerationType, NodeType, SymbolType, TruthTable>> symbols;
 
     auto node_types = get_symbol_types();
     auto terminal_node_types = get_terminal_symbol_types();
 
     for (const auto& element : node_types)
     {
-      enumeration_symbol<EnumerationType, NodeType, SymbolType> symbol;
+      enumeration_symbol<EnumerationType, NodeType, SymbolType, TruthTable> symbol;
       symbol.type = element;
       symbol.children = get_possible_children(element);
       symbol.num_children = get_num_children(element);
       symbol.node_constructor = get_node_constructor(element);
       symbol.node_operation = get_node_operation(element);
+      symbol.node_operation_inplace = get_node_operation_inplace(element);
       symbol.attributes = get_enumeration_attributes(element);
       if (std::find(terminal_node_types.begin(), terminal_node_types.end(), element) != terminal_node_types.end()) { // this is a terminal symbol
         symbol.terminal_symbol = true;
@@ -150,6 +158,6 @@ public:
       symbols.emplace_back(symbol);
     }
 
-    return grammar<EnumerationType, NodeType, SymbolType>(symbols, get_possible_roots_types(), get_terminal_symbol_types());
+    return grammar<EnumerationType, NodeType, SymbolType, TruthTable>(symbols, get_possible_roots_types(), get_terminal_symbol_types());
   }
 };
@@ -0,0 +1,235 @@
+/* MIT License
+ *
+ * Copyright (c) 2020 Gianluca Martino
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "truth_table_traits.hpp"
+
+namespace enumeration_tool {
+
+// Dense 32-bit IDs for the truth tables of num_vars inputs: the words of the tables are stored one after the other in an
+// arena, an open-addressing index maps them to their ID. A table is hashed once when it is interned, the maps of the
+// engine are then indexed by ID (see id_map). Not thread-safe.
+// With up to max_direct_vars inputs all the functions fit in a 16-bit ID: the ID is the value of the truth table itself,
+// nothing is stored and every function reads as interned.
+template <typename TruthTable>
+class truth_table_interner {
+public:
+  static constexpr uint32_t npos = std::numeric_limits<uint32_t>::max();
+  static constexpr uint32_t max_direct_vars = 4u;
+
+  explicit truth_table_interner(uint32_t num_vars)
+    : _num_vars{ num_vars }
+    , _num_words{ static_cast<std::size_t>(truth_table_traits<TruthTable>::construct(num_vars).num_blocks()) }
+    , _direct_mask{ num_vars <= max_direct_vars ? (uint64_t{ 1 } << (1u << num_vars)) - 1u : 0u }
+    , _slots(is_direct() ? 0u : 1024u, npos)
+  {}
+
+  auto intern(const TruthTable& tt) -> uint32_t
+  {
+    if (is_direct()) {
+      return static_cast<uint32_t>(*tt.cbegin() & _direct_mask);
+    }
+    const auto* words = &*tt.cbegin();
+    const auto hash = hash_words(words);
+    auto& slot = _slots[probe(words, hash)];
+    if (slot != npos) {
+      return slot;
+    }
+
+    slot = static_cast<uint32_t>(_hashes.size());
+    _words.insert(_words.end(), words, words + _num_words);
+    _hashes.push_back(hash);
+    if (_hashes.size() * 2 > _slots.size()) {
+      grow();
+    }
+    return static_cast<uint32_t>(_hashes.size() - 1);
+  }
+
+  // npos if the table was never interned
+  [[nodiscard]]
+  auto find(const TruthTable& tt) const -> uint32_t
+  {
+    if (is_direct()) {
+      return static_cast<uint32_t>(*tt.cbegin() & _direct_mask);
+    }
+    const auto* words = &*tt.cbegin();
+    return _slots[probe(words, hash_words(words))];
+  }
+
+  [[nodiscard]]
+  auto truth_table(uint32_t id) const -> TruthTable
+  {
+    auto tt = truth_table_traits<TruthTable>::construct(_num_vars);
+    if (is_direct()) {
+      *tt.begin() = id;
+    }
+    else {
+      std::copy(words(id), words(id) + _num_words, tt.begin());
+    }
+    return tt;
+  }
+
+  // in direct mode: the number of functions
+  [[nodiscard]]
+  auto size() const -> uint32_t
+  {
+    return is_direct() ? static_cast<uint32_t>(_direct_mask + 1u) : static_cast<uint32_t>(_hashes.size());
+  }
+
+  [[nodiscard]]
+  auto is_direct() const -> bool
+  {
+    return _direct_mask != 0u;
+  }
+
+  [[nodiscard]]
+  auto num_vars() const -> uint32_t
+  {
+    return _num_vars;
+  }
+
+private:
+  auto words(uint32_t id) const -> const uint64_t*
+  {
+    return &_words[static_cast<std::size_t>(id) * _num_words];
+  }
+
+  auto hash_words(const uint64_t* words) const -> uint64_t
+  {
+    auto hash = uint64_t{ 0 };
+    for (auto i = 0ul; i < _num_words; ++i) {
+      hash = (hash ^ words[i]) * 0x9e3779b97f4a7c15ull;
+      hash ^= hash >> 29u;
+    }
+    return hash;
+  }
+
+  // the slot of the table, or the empty slot where it would go
+  auto probe(const uint64_t* words, uint64_t hash) const -> std::size_t
+  {
+    const auto mask = _slots.size() - 1;
+    for (auto slot = hash & mask;; slot = (slot + 1) & mask) {
+      const auto id = _slots[slot];
+      if (id == npos || (_hashes[id] == hash && std::equal(words, words + _num_words, this->words(id)))) {
+        return slot;
+      }
+    }
+  }
+
+  void grow()
+  {
+    _slots.assign(_slots.size() * 2, npos);
+    const auto mask = _slots.size() - 1;
+    for (auto id = 0u; id < _hashes.size(); ++id) {
+      auto slot = _hashes[id] & mask;
+      while (_slots[slot] != npos) {
+        slot = (slot + 1) & mask;
+      }
+      _slots[slot] = id;
+    }
+  }
+
+  uint32_t _num_vars;
+  std::size_t _num_words;
+  uint64_t _direct_mask; // 0 if not in direct mode
+  std::vector<uint64_t> _words; // the arena
+  std::vector<uint64_t> _hashes; // for each ID
+  std::vector<uint32_t> _slots; // power of two, at most half full
+};
+
+// Values indexed by the IDs of a truth_table_interner, in a flat array that grows with the IDs. clear() only starts a
+// new generation: the entries of the previous ones read as absent.
+template <typename T>
+class id_map {
+public:
+  [[nodiscard]]
+  auto contains(uint32_t id) const -> bool
+  {
+    return id < _generations.size() && _generations[id] == _generation;
+  }
+
+  // nullptr if absent
+  [[nodiscard]]
+  auto find(uint32_t id) const -> const T*
+  {
+    return contains(id) ? &_values[id] : nullptr;
+  }
+
+  [[nodiscard]]
+  auto find(uint32_t id) -> T*
+  {
+    return contains(id) ? &_values[id] : nullptr;
+  }
+
+  // as std::unordered_map::emplace: an existing value is kept
+  auto emplace(uint32_t id, const T& value) -> bool
+  {
+    if (id >= _generations.size()) {
+      reserve(std::max<std::size_t>(id + 1, _generations.size() * 2));
+    }
+    if (_generations[id] == _generation) {
+      return false;
+    }
+    _generations[id] = _generation;
+    _values[id] = value;
+    return true;
+  }
+
+  // IDs below size are then set without growing
+  void reserve(std::size_t size)
+  {
+    if (size > _generations.size()) {
+      _generations.resize(size, 0);
+      _values.resize(size);
+    }
+  }
+
+  void erase(uint32_t id)
+  {
+    if (contains(id)) {
+      _generations[id] = 0;
+    }
+  }
+
+  void clear()
+  {
+    if (++_generation == 0) { // wrapped around
+      std::fill(_generations.begin(), _generations.end(), 0);
+      _generation = 1;
+    }
+  }
+
+private:
+  std::vector<uint32_t> _generations; // 0: never set
+  std::vector<T> _values;
+  uint32_t _generation = 1;
+};
+
+} // namespace enumeration_tool
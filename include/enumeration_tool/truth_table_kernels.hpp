@@ -0,0 +1,277 @@
+/* MIT License
+ *
+ * Copyright (c) 2020 Gianluca Martino
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define ENUMERATION_TOOL_KERNEL_DISPATCH
+#define ENUMERATION_TOOL_KERNEL_INLINE inline __attribute__((always_inline))
+#else
+#define ENUMERATION_TOOL_KERNEL_INLINE inline
+#endif
+
+namespace enumeration_tool {
+
+// Word loops of the gate operators, for truth tables of more than 6 inputs (the words of the output may be the words of
+// an input). On x86 the loops run on 512 or 256 bits at a time if the CPU has AVX-512 or AVX2, the instruction set is
+// selected once at runtime; elsewhere, and for tables of a few words, the loops run one word at a time. The results are
+// not masked: with less than 6 inputs the unused bits of the word are left to the caller.
+namespace kernels {
+
+enum class instruction_set {
+  portable, avx2, avx512
+};
+
+// below this the portable loop is faster than the dispatch
+inline constexpr std::size_t min_dispatch_words = 4;
+// below this the 512-bit loop is slower than the 256-bit one
+inline constexpr std::size_t min_avx512_words = 16;
+
+namespace detail {
+
+inline auto complement_mask(bool complement) -> uint64_t
+{
+  return complement ? ~uint64_t{ 0 } : uint64_t{ 0 };
+}
+
+// the operators, Word is uint64_t or a vector of them: the operations with the masks apply to every element
+
+struct unary_op {
+  uint64_t complement_out;
+
+  template <typename Word>
+  ENUMERATION_TOOL_KERNEL_INLINE void operator()(Word& out, const Word& a) const
+  {
+    out = a ^ complement_out;
+  }
+};
+
+struct and_op {
+  uint64_t complement_a;
+  uint64_t complement_b;
+  uint64_t complement_out;
+
+  template <typename Word>
+  ENUMERATION_TOOL_KERNEL_INLINE void operator()(Word& out, const Word& a, const Word& b) const
+  {
+    out = ((a ^ complement_a) & (b ^ complement_b)) ^ complement_out;
+  }
+};
+
+struct xor_op {
+  uint64_t complement_out;
+
+  template <typename Word>
+  ENUMERATION_TOOL_KERNEL_INLINE void operator()(Word& out, const Word& a, const Word& b) const
+  {
+    out = a ^ b ^ complement_out;
+  }
+};
+
+// any function of two inputs: one mask for each minterm
+struct function_op {
+  uint64_t minterms[4];
+
+  template <typename Word>
+  ENUMERATION_TOOL_KERNEL_INLINE void operator()(Word& out, const Word& a, const Word& b) const
+  {
+    out = (~a & ~b & minterms[0]) | (a & ~b & minterms[1]) | (~a & b & minterms[2]) | (a & b & minterms[3]);
+  }
+};
+
+struct maj_op {
+  uint64_t complement_a;
+  uint64_t complement_b;
+  uint64_t complement_c;
+  uint64_t complement_out;
+
+  template <typename Word>
+  ENUMERATION_TOOL_KERNEL_INLINE void operator()(Word& out, const Word& a, const Word& b, const Word& c) const
+  {
+    const Word x = a ^ complement_a;
+    const Word y = b ^ complement_b;
+    const Word z = c ^ complement_c;
+    out = ((x & (y | z)) | (y & z)) ^ complement_out;
+  }
+};
+
+template <typename Word>
+ENUMERATION_TOOL_KERNEL_INLINE void load(Word& word, const uint64_t* words)
+{
+  std::memcpy(&word, words, sizeof(Word));
+}
+
+// out[i] = op(inputs[i]...): Word at a time, then the remaining words one by one
+template <typename Word, typename Op, typename... Inputs>
+ENUMERATION_TOOL_KERNEL_INLINE void word_loop(uint64_t* out, std::size_t num_words, const Op& op, const Inputs*... inputs)
+{
+  constexpr auto lanes = sizeof(Word) / sizeof(uint64_t);
+  auto i = std::size_t{ 0 };
+  if constexpr (lanes > 1) {
+    for (; i + lanes <= num_words; i += lanes) {
+      Word words[sizeof...(Inputs)];
+      auto k = 0u;
+      (load(words[k++], inputs + i), ...);
+      Word result;
+      if constexpr (sizeof...(Inputs) == 1) {
+        op(result, words[0]);
+      }
+      else if constexpr (sizeof...(Inputs) == 2) {
+        op(result, words[0], words[1]);
+      }
+      else {
+        op(result, words[0], words[1], words[2]);
+      }
+      std::memcpy(out + i, &result, sizeof(Word));
+    }
+  }
+  for (; i < num_words; ++i) {
+    op(out[i], inputs[i]...);
+  }
+}
+
+#ifdef ENUMERATION_TOOL_KERNEL_DISPATCH
+
+typedef uint64_t avx2_word __attribute__((vector_size(32)));
+typedef uint64_t avx512_word __attribute__((vector_size(64)));
+
+template <typename Op, typename... Inputs>
+__attribute__((target("avx2"))) void avx2_loop(uint64_t* out, std::size_t num_words, const Op& op, const Inputs*... inputs)
+{
+  word_loop<avx2_word>(out, num_words, op, inputs...);
+}
+
+template <typename Op, typename... Inputs>
+__attribute__((target("avx512f"))) void avx512_loop(uint64_t* out, std::size_t num_words, const Op& op, const Inputs*... inputs)
+{
+  const auto blocks = num_words & ~std::size_t{ 7 };
+  word_loop<avx512_word>(out, blocks, op, inputs...);
+  word_loop<avx2_word>(out + blocks, num_words - blocks, op, (inputs + blocks)...); // the last 4 words
+}
+
+inline auto detect_instruction_set() -> instruction_set
+{
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) {
+    return instruction_set::avx512;
+  }
+  if (__builtin_cpu_supports("avx2")) {
+    return instruction_set::avx2;
+  }
+  return instruction_set::portable;
+}
+
+#else
+
+inline auto detect_instruction_set() -> instruction_set
+{
+  return instruction_set::portable;
+}
+
+#endif
+
+inline auto selected_instruction_set() -> instruction_set&
+{
+  static instruction_set selected = detect_instruction_set();
+  return selected;
+}
+
+template <typename Op, typename... Inputs>
+inline void run(uint64_t* out, std::size_t num_words, const Op& op, const Inputs*... inputs)
+{
+#ifdef ENUMERATION_TOOL_KERNEL_DISPATCH
+  if (num_words >= min_dispatch_words) {
+    switch (selected_instruction_set()) {
+      case instruction_set::avx512:
+        if (num_words >= min_avx512_words) {
+          avx512_loop(out, num_words, op, inputs...);
+          return;
+        }
+        [[fallthrough]];
+      case instruction_set::avx2: avx2_loop(out, num_words, op, inputs...); return;
+      case instruction_set::portable: break;
+    }
+  }
+#endif
+  word_loop<uint64_t>(out, num_words, op, inputs...);
+}
+
+} // namespace detail
+
+// the best instruction set of the CPU
+inline auto supported_instruction_set() -> instruction_set
+{
+  static const instruction_set supported = detail::detect_instruction_set();
+  return supported;
+}
+
+inline auto active_instruction_set() -> instruction_set
+{
+  return detail::selected_instruction_set();
+}
+
+// for tests and benchmarks, not while an enumeration is running: restricts the kernels to an instruction set, up to the
+// supported one
+inline void use_instruction_set(instruction_set set)
+{
+  detail::selected_instruction_set() = static_cast<int>(set) <= static_cast<int>(supported_instruction_set()) ? set : supported_instruction_set();
+}
+
+inline void not_words(uint64_t* out, const uint64_t* a, std::size_t num_words)
+{
+  detail::run(out, num_words, detail::unary_op{ ~uint64_t{ 0 } }, a);
+}
+
+inline void and_words(uint64_t* out, const uint64_t* a, const uint64_t* b, std::size_t num_words, bool complement_a = false, bool complement_b = false, bool complement_out = false)
+{
+  detail::run(out, num_words, detail::and_op{ detail::complement_mask(complement_a), detail::complement_mask(complement_b), detail::complement_mask(complement_out) }, a, b);
+}
+
+inline void xor_words(uint64_t* out, const uint64_t* a, const uint64_t* b, std::size_t num_words, bool complement_out = false)
+{
+  detail::run(out, num_words, detail::xor_op{ detail::complement_mask(complement_out) }, a, b);
+}
+
+inline void maj_words(uint64_t* out, const uint64_t* a, const uint64_t* b, const uint64_t* c, std::size_t num_words, bool complement_a = false, bool complement_b = false, bool complement_c = false, bool complement_out = false)
+{
+  detail::run(out, num_words, detail::maj_op{ detail::complement_mask(complement_a), detail::complement_mask(complement_b), detail::complement_mask(complement_c), detail::complement_mask(complement_out) }, a, b, c);
+}
+
+// the function of two inputs given by its truth table: bit j is the output for a = j & 1, b = j >> 1
+inline void binary_function_words(uint64_t* out, const uint64_t* a, const uint64_t* b, std::size_t num_words, unsigned function)
+{
+  detail::function_op op{};
+  for (auto j = 0u; j < 4u; ++j) {
+    op.minterms[j] = detail::complement_mask((function >> j) & 1u);
+  }
+  detail::run(out, num_words, op, a, b);
+}
+
+} // namespace kernels
+
+} // namespace enumeration_tool
@@ -0,0 +1,59 @@
+/* MIT License
+ *
+ * Copyright (c) 2020 Gianluca Martino
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+
+#include <kitty/dynamic_truth_table.hpp>
+#include <kitty/static_truth_table.hpp>
+
+// Truth table policy used by the grammar and the engines for simulation.
+// kitty::dynamic_truth_table works for any number of inputs, kitty::static_truth_table<N> with N <= 6 keeps the whole
+// function in a single uint64_t (no heap allocation when simulating, hashing or comparing).
+template <typename TruthTable>
+struct truth_table_traits;
+
+template <>
+struct truth_table_traits<kitty::dynamic_truth_table>
+{
+  static constexpr bool is_fixed_width = false;
+
+  static auto construct(uint32_t num_vars) -> kitty::dynamic_truth_table
+  {
+    return kitty::dynamic_truth_table(num_vars);
+  }
+};
+
+template <int NumVars, bool SmallTruthTable>
+struct truth_table_traits<kitty::static_truth_table<NumVars, SmallTruthTable>>
+{
+  static constexpr bool is_fixed_width = SmallTruthTable; // true if it fits in a single word
+
+  static auto construct([[maybe_unused]] uint32_t num_vars) -> kitty::static_truth_table<NumVars, SmallTruthTable>
+  {
+    assert(num_vars == NumVars);
+    return {};
+  }
+};
@@ -26,8 +26,16 @@
 #include <vector>
 #include <chrono>
 #include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstdint>
 #include <ctime>
+#include <functional>
 #include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include <nauty.h>
 
 #ifdef PERFORMANCE_MONITORING
   #define START_CLOCK() \
@@ -65,61 +73,78 @@ inline bool is_leaf_node(const std::vector<int> node) {
   return node[0] == 0 && std::adjacent_find(node.begin(), node.end(), std::not_equal_to<>()) == node.end();
 }
 
-inline std::string create_hex_string(int num_inputs, bool value)
-{
-  std::vector<std::string> hex_values = {"F", "0"};
-  std::stringstream ss;
-
-  if (value) {
-    for (int i = 0; i < (1 << (num_inputs - 2)); i++) {
-      ss << hex_values[0];
-    }
-  }
-  else {
-    for (int i = 0; i < (1 << (num_inputs - 2)); i++) {
-      ss << hex_values[1];
-    }
+// word word_index of the truth table of the projection on variable var, without the mask of the functions of less than 6 inputs
+constexpr uint64_t projection_word(uint32_t var, std::size_t word_index) {
+  constexpr uint64_t patterns[] = {
+    0xaaaaaaaaaaaaaaaa, 0xcccccccccccccccc, 0xf0f0f0f0f0f0f0f0, 0xff00ff00ff00ff00, 0xffff0000ffff0000, 0xffffffff00000000
+  };
+  if (var < 6) {
+    return patterns[var];
   }
-
-  return ss.str();
+  return ((word_index >> (var - 6)) & 1u) ? ~uint64_t(0) : uint64_t(0);
 }
 
-inline std::string create_hex_string(int num_inputs, int input_index) {
-  assert(num_inputs > 1);
-  assert(input_index < num_inputs);
+// truth tables of the constants and of the projections, generated at compile time up to max_terminal_vars inputs
+inline constexpr uint32_t max_terminal_vars = 16;
 
-  std::vector<std::string> hex_values = {"A", "C", "F", "0"};
-  std::stringstream ss;
+constexpr auto terminal_num_words(uint32_t num_vars) -> std::size_t {
+  return num_vars <= 6 ? 1u : std::size_t{ 1 } << (num_vars - 6);
+}
 
-  if (input_index == 0) {
-    for (int i = 0; i < (1 << (num_inputs - 2)); i++) {
-      ss << hex_values[0];
-    }
-  }
-  else if (input_index == 1) {
-    for (int i = 0; i < (1 << (num_inputs - 2)); i++) {
-      ss << hex_values[1];
-    }
+namespace detail {
+
+constexpr auto terminal_tables_num_words() -> std::size_t {
+  std::size_t words = 0;
+  for (auto num_vars = 0u; num_vars <= max_terminal_vars; ++num_vars) {
+    words += (num_vars + 2) * terminal_num_words(num_vars);
   }
-  else {
-    int num_hex_values = 1 << (num_inputs - 2);
-    int groups_size = 1 << (input_index - 2);
-
-    bool flag = false; // invert this flag for changing the endianness
-    for (int i = 0; i < (num_hex_values/groups_size); ++i) {
-      for (int j = 0; j < groups_size; ++j) {
-        if (!flag) {
-          ss << hex_values[2];
-        }
-        else {
-          ss << hex_values[3];
-        }
+  return words;
+}
+
+// for each number of inputs: the constant 0, the constant 1 and the projections, the unused bits set to 0 as in kitty
+struct terminal_tables_t {
+  std::array<std::size_t, max_terminal_vars + 1> offsets{};
+  std::array<uint64_t, terminal_tables_num_words()> words{};
+};
+
+constexpr auto make_terminal_tables() -> terminal_tables_t {
+  terminal_tables_t tables{};
+  std::size_t offset = 0;
+  for (auto num_vars = 0u; num_vars <= max_terminal_vars; ++num_vars) {
+    const auto num_words = terminal_num_words(num_vars);
+    const auto mask = num_vars < 6 ? (uint64_t{ 1 } << (1u << num_vars)) - 1 : ~uint64_t{ 0 };
+    tables.offsets[num_vars] = offset;
+    for (auto i = 0ul; i < num_words; ++i) {
+      tables.words[offset + i] = 0;
+      tables.words[offset + num_words + i] = mask;
+      for (auto var = 0u; var < num_vars; ++var) {
+        tables.words[offset + (var + 2) * num_words + i] = projection_word(var, i) & mask;
       }
-      flag = !flag;
     }
+    offset += (num_vars + 2) * num_words;
   }
+  return tables;
+}
+
+inline constexpr terminal_tables_t terminal_tables = make_terminal_tables();
 
-  return ss.str();
+} // namespace detail
+
+// the terminal_num_words(num_vars) words of the truth table of the constant
+constexpr auto constant_words(uint32_t num_vars, bool value) -> const uint64_t* {
+  if (num_vars > max_terminal_vars) {
+    throw std::runtime_error("No precomputed truth tables for this number of inputs");
+  }
+  return &detail::terminal_tables.words[detail::terminal_tables.offsets[num_vars] + (value ? terminal_num_words(num_vars) : 0)];
+}
+
+// the terminal_num_words(num_vars) words of the truth table of the projection on variable var
+constexpr auto projection_words(uint32_t num_vars, uint32_t var) -> const uint64_t* {
+  assert(var < num_vars);
+  if (num_vars > max_terminal_vars) {
+    throw std::runtime_error("No precomputed truth tables for this number of inputs");
+  }
+  return &detail::terminal_tables.words[detail::terminal_tables.offsets[num_vars] + (var + 2) * terminal_num_words(num_vars)];
 }
 
 template<typename TimeT = std::chrono::milliseconds>
@@ -0,0 +1,25 @@
+#include "counting_new.hpp"
+
+#include <cstdlib>
+#include <new>
+
+std::atomic<bool> count_allocations{false};
+std::atomic<std::size_t> num_allocations{0};
+
+void* operator new(std::size_t size) {
+  if (count_allocations.load(std::memory_order_relaxed)) {
+    num_allocations.fetch_add(1, std::memory_order_relaxed);
+  }
+  if (auto* ptr = std::malloc(size == 0 ? 1 : size)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+  std::free(ptr);
+}
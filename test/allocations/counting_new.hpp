@@ -0,0 +1,19 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+// the global operator new of the allocation tests counts the allocations while count_allocations is set; it is
+// replaced in its own translation unit, so that it is never inlined next to a delete expression
+extern std::atomic<bool> count_allocations;
+extern std::atomic<std::size_t> num_allocations;
+
+// heap allocations made by fn (all threads)
+template<typename Fn>
+auto allocations_in(Fn&& fn) -> std::size_t {
+  num_allocations = 0;
+  count_allocations = true;
+  fn();
+  count_allocations = false;
+  return num_allocations;
+}
@@ -0,0 +1,32 @@
+#define CATCH_CONFIG_MAIN
+#include <catch.hpp>
+
+#include <enumeration_tool/enumerator_engines/partial_dag_enumerator.hpp>
+#include <enumeration_tool/enumerators/aig_enumerator.hpp>
+
+#include "../../experiments/graphs_generation.hpp"
+#include "counting_new.hpp"
+
+TEST_CASE( "in-place node operations save the allocations", "[partial_dag_enumerator]" )
+{
+  using enumerator_t = enumeration_tool::partial_dag_enumerator<mockturtle::aig_network, mockturtle::aig_network::signal, EnumerationSymbols>;
+
+  class allocating_interface : public aig_enumeration_interface {
+  public:
+    auto get_node_operation_inplace(SymbolType) -> node_operation_inplace_callback_fn override { return nullptr; }
+  };
+
+  std::vector<percy::partial_dag> generated = generate_dags(1, 4);
+
+  aig_enumeration_interface inplace_store;
+  enumerator_t inplace_en(inplace_store.build_grammar(), std::make_shared<aig_enumeration_interface>());
+  auto inplace_allocations = allocations_in([&]() { inplace_en.enumerate_aig_pre_enumeration(generated); });
+
+  allocating_interface allocating_store;
+  enumerator_t allocating_en(allocating_store.build_grammar(), std::make_shared<allocating_interface>());
+  auto allocating_allocations = allocations_in([&]() { allocating_en.enumerate_aig_pre_enumeration(generated); });
+
+  REQUIRE(inplace_en.simulated_nodes == allocating_en.simulated_nodes);
+  // each node operation returning a new TT allocates at least once, the in-place ones do not
+  REQUIRE(allocating_allocations >= inplace_allocations + allocating_en.simulated_nodes);
+}
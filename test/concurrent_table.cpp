@@ -0,0 +1,152 @@
+#include <enumeration_tool/concurrent_table.hpp>
+
+#include "catch2/catch.hpp"
+
+#include <kitty/constructors.hpp>
+#include <kitty/dynamic_truth_table.hpp>
+#include <kitty/operators.hpp>
+
+#include <algorithm>
+#include <optional>
+#include <thread>
+#include <vector>
+
+TEST_CASE( "insert and min-update", "[concurrent_table]" )
+{
+  enumeration_tool::concurrent_table table(10);
+  REQUIRE(table.capacity() == 16);
+
+  REQUIRE(table.insert(0x96, 5));
+  REQUIRE(!table.insert(0x96, 3));
+  REQUIRE(*table.find(0x96) == 5);
+  REQUIRE(!table.find(0x69));
+
+  std::optional<uint32_t> previous;
+  REQUIRE(table.update_min(0x69, 4, previous));
+  REQUIRE(!previous);
+  REQUIRE(table.update_min(0x69, 6, previous));
+  REQUIRE(*previous == 4);
+  REQUIRE(*table.find(0x69) == 4);
+  REQUIRE(table.update_min(0x69, 2, previous));
+  REQUIRE(*previous == 4);
+  REQUIRE(*table.find(0x69) == 2);
+
+  REQUIRE(table.insert(0)); // every key is valid
+  REQUIRE(table.insert(~uint64_t{ 0 }));
+  REQUIRE(table.size() == 4);
+
+  for (uint64_t key = 1; !table.full(); ++key) {
+    table.insert(key << 8u);
+  }
+  REQUIRE(table.size() == 12);
+  REQUIRE(!table.insert(0x12345)); // refused, not thrown
+  REQUIRE(!table.contains(0x12345));
+  REQUIRE(!table.update_min(0x12345, 1, previous));
+  REQUIRE(table.update_min(0x69, 1, previous)); // the keys already there can still be updated
+  REQUIRE(*table.find(0x69) == 1);
+  REQUIRE(table.contains(0x96));
+}
+
+TEST_CASE( "concurrent min-update", "[concurrent_table]" )
+{
+  const auto num_keys = 1000u;
+  const auto num_threads = 4u;
+  enumeration_tool::concurrent_table table(2 * num_keys);
+
+  std::vector<std::thread> threads;
+  for (auto t = 0u; t < num_threads; ++t) {
+    threads.emplace_back([&, t] {
+      for (auto key = 0u; key < num_keys; ++key) {
+        std::optional<uint32_t> previous;
+        table.update_min(key * 0x9e3779b97f4a7c15ull, 10 + (key + t) % num_threads, previous);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  REQUIRE(table.size() == num_keys);
+  auto visited = 0u;
+  table.foreach_entry([&](uint64_t, uint32_t value) {
+    REQUIRE(value == 10);
+    ++visited;
+  });
+  REQUIRE(visited == num_keys);
+}
+
+TEST_CASE( "size table on wide functions", "[concurrent_table]" )
+{
+  for (auto num_vars : {3u, 7u}) {
+    enumeration_tool::concurrent_size_table<kitty::dynamic_truth_table> table(num_vars, 64);
+    kitty::dynamic_truth_table a(num_vars), b(num_vars);
+    kitty::create_nth_var(a, 0);
+    kitty::create_nth_var(b, num_vars - 1);
+
+    REQUIRE(table.insert(a, 5));
+    REQUIRE(!table.insert(a, 7));
+    REQUIRE(!table.update_min(a & b, 3));
+    REQUIRE(*table.update_min(a & b, 2) == 3);
+    REQUIRE(table.size() == 2);
+
+    auto visited = 0u;
+    table.foreach_entry([&](const kitty::dynamic_truth_table& tt, uint32_t size) {
+      REQUIRE(tt.num_vars() == num_vars);
+      REQUIRE(size == (tt == a ? 5u : 2u));
+      ++visited;
+    });
+    REQUIRE(visited == 2);
+  }
+}
+
+TEST_CASE( "size table overflows into the shards", "[concurrent_table]" )
+{
+  enumeration_tool::concurrent_size_table<kitty::dynamic_truth_table> table(3, 16);
+  kitty::dynamic_truth_table tt(3);
+  for (uint64_t word = 0; word < 256; ++word) {
+    kitty::create_from_words(tt, &word, &word + 1);
+    REQUIRE(table.insert(tt, word % 7));
+  }
+  REQUIRE(table.size() == 256);
+
+  for (uint64_t word = 0; word < 256; ++word) {
+    kitty::create_from_words(tt, &word, &word + 1);
+    REQUIRE(*table.find(tt) == word % 7);
+    REQUIRE(*table.update_min(tt, 0) == word % 7);
+  }
+
+  auto visited = 0u;
+  table.foreach_entry([&](const kitty::dynamic_truth_table&, uint32_t size) {
+    REQUIRE(size == 0);
+    ++visited;
+  });
+  REQUIRE(visited == 256);
+}
+
+TEST_CASE( "concurrent overflow into the shards", "[concurrent_table]" )
+{
+  const auto num_threads = 4u;
+  enumeration_tool::concurrent_size_table<kitty::dynamic_truth_table> table(3, 16);
+
+  std::vector<std::thread> threads;
+  for (auto t = 0u; t < num_threads; ++t) {
+    threads.emplace_back([&, t] {
+      kitty::dynamic_truth_table tt(3);
+      for (uint64_t word = 0; word < 256; ++word) {
+        kitty::create_from_words(tt, &word, &word + 1);
+        table.update_min(tt, 10 + (word + t) % num_threads);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  // each function once, with its smallest size
+  std::vector<unsigned> visits(256);
+  table.foreach_entry([&](const kitty::dynamic_truth_table& tt, uint32_t size) {
+    REQUIRE(size == 10);
+    ++visits[*tt.cbegin()];
+  });
+  REQUIRE(std::all_of(visits.begin(), visits.end(), [](auto visited) { return visited == 1; }));
+}
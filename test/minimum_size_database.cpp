@@ -0,0 +1,58 @@
+#include <enumeration_tool/minimum_size_database.hpp>
+#include <kitty/constructors.hpp>
+#include <kitty/dynamic_truth_table.hpp>
+
+#include "catch2/catch.hpp"
+
+#include <cstdio>
+
+TEST_CASE( "records", "[minimum_size_database]" )
+{
+  const std::string filename = "test_minimum_size_database.db";
+  std::remove(filename.c_str());
+
+  kitty::dynamic_truth_table tt3(3);
+  kitty::create_from_hex_string(tt3, "e8");
+  kitty::dynamic_truth_table tt7(7);
+  kitty::create_majority(tt7);
+
+  {
+    enumeration_tool::minimum_size_database database(filename);
+    REQUIRE(database.size() == 0);
+    REQUIRE(database.insert(tt3, 4, 2, {0, 1, 2, 3, 4, 5, 6}));
+    REQUIRE(database.insert(tt7, 20, 7, {1}));
+    REQUIRE(!database.insert(tt3, 5, 3, {}));
+    REQUIRE(database.size() == 2);
+  } // flushed on destruction
+
+  {
+    enumeration_tool::minimum_size_database database(filename);
+    REQUIRE(database.size() == 2);
+    auto record = database.find(tt3);
+    REQUIRE(record);
+    REQUIRE(record->size == 4);
+    REQUIRE(record->dag_index == 2);
+    REQUIRE(record->assignment == std::vector<int>{0, 1, 2, 3, 4, 5, 6});
+    REQUIRE(database.find(tt7)->size == 20);
+
+    REQUIRE(database.insert(tt3, 3, 1, {6, 5}));
+    database.flush();
+    REQUIRE(database.find(tt3)->size == 3);
+
+    int count = 0;
+    database.foreach_entry(3, [&](const uint64_t* words, int32_t size) {
+      REQUIRE(words[0] == 0xe8);
+      REQUIRE(size == 3);
+      count++;
+    });
+    REQUIRE(count == 1);
+  }
+
+  {
+    enumeration_tool::minimum_size_database database(filename);
+    REQUIRE(database.size() == 2);
+    REQUIRE(database.find(tt3)->assignment == std::vector<int>{6, 5});
+  }
+
+  std::remove(filename.c_str());
+}
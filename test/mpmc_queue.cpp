@@ -0,0 +1,69 @@
+#include <enumeration_tool/mpmc_queue.hpp>
+
+#include "catch2/catch.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+TEST_CASE( "push and pop", "[mpmc_queue]" )
+{
+  enumeration_tool::mpmc_queue<uint64_t> queue(3);
+  REQUIRE(queue.capacity() == 4);
+  REQUIRE(!queue.try_pop());
+
+  for (uint64_t i = 0; i < 4; ++i) {
+    REQUIRE(queue.try_push(i));
+  }
+  REQUIRE(!queue.try_push(4)); // full
+  REQUIRE(*queue.try_pop() == 0);
+  REQUIRE(queue.try_push(4));
+  for (uint64_t i = 1; i <= 4; ++i) {
+    REQUIRE(*queue.try_pop() == i);
+  }
+  REQUIRE(!queue.try_pop());
+}
+
+TEST_CASE( "concurrent producers and consumers", "[mpmc_queue]" )
+{
+  const auto num_values = 10000u;
+  const auto num_threads = 3u;
+  enumeration_tool::mpmc_queue<uint64_t> queue(8);
+
+  std::vector<std::thread> producers;
+  for (auto t = 0u; t < num_threads; ++t) {
+    producers.emplace_back([&, t] {
+      for (uint64_t value = t; value < num_values; value += num_threads) {
+        while (!queue.try_push(value)) {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+
+  std::vector<int> seen(num_values, 0);
+  std::atomic<unsigned> num_popped = 0;
+  std::vector<std::thread> consumers;
+  for (auto t = 0u; t < num_threads; ++t) {
+    consumers.emplace_back([&] {
+      while (num_popped < num_values) {
+        if (auto value = queue.try_pop()) {
+          seen[*value]++;
+          num_popped++;
+        }
+        else {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (auto& thread : producers) {
+    thread.join();
+  }
+  for (auto& thread : consumers) {
+    thread.join();
+  }
+
+  REQUIRE(std::all_of(seen.begin(), seen.end(), [](int n) { return n == 1; }));
+}
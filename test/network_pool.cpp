@@ -0,0 +1,68 @@
+#include <enumeration_tool/network_pool.hpp>
+
+#include "catch2/catch.hpp"
+
+#include <mockturtle/networks/aig.hpp>
+
+#include <memory>
+#include <vector>
+
+namespace {
+
+using pool_t = enumeration_tool::network_pool<mockturtle::aig_network, mockturtle::aig_network::signal>;
+
+auto acquire(pool_t& pool) -> std::shared_ptr<mockturtle::aig_network>
+{
+  return pool.acquire([](const std::shared_ptr<mockturtle::aig_network>& ntk, std::vector<mockturtle::aig_network::signal>& leaves) {
+    leaves = { ntk->create_pi(), ntk->create_pi(), ntk->create_pi() };
+  });
+}
+
+} // namespace
+
+TEST_CASE( "networks are restored to their inputs", "[network_pool]" )
+{
+  pool_t pool;
+  auto ntk = acquire(pool);
+  auto* first = ntk.get();
+  ntk->create_po(ntk->create_and(pool.leaves[0], ntk->create_and(pool.leaves[1], !pool.leaves[2])));
+  REQUIRE(ntk->num_gates() == 2);
+  ntk.reset();
+
+  for (auto i = 0; i < 3; ++i) {
+    ntk = acquire(pool);
+    REQUIRE(ntk.get() == first);
+    REQUIRE(ntk->num_pis() == 3);
+    REQUIRE(ntk->num_pos() == 0);
+    REQUIRE(ntk->num_gates() == 0);
+    REQUIRE(ntk->fanout_size(ntk->get_node(pool.leaves[0])) == 0);
+
+    // the structural hashing starts again from scratch
+    auto gate = ntk->create_and(pool.leaves[0], pool.leaves[1]);
+    REQUIRE(ntk->create_and(pool.leaves[1], pool.leaves[0]) == gate);
+    ntk->create_po(gate);
+    REQUIRE(ntk->num_gates() == 1);
+    ntk.reset();
+  }
+  REQUIRE(pool.num_created == 1);
+}
+
+TEST_CASE( "networks kept by the caller are not reused", "[network_pool]" )
+{
+  pool_t pool(1);
+  auto kept = acquire(pool);
+  kept->create_po(kept->create_and(pool.leaves[0], pool.leaves[1]));
+
+  auto other = acquire(pool);
+  REQUIRE(other != kept);
+  REQUIRE(pool.num_created == 2);
+  REQUIRE(kept->num_gates() == 1);
+  other.reset();
+
+  // a copy of the network shares its storage
+  mockturtle::aig_network copy = *acquire(pool);
+  auto again = acquire(pool);
+  REQUIRE(again->_storage != copy._storage);
+  REQUIRE(pool.num_created == 3);
+  REQUIRE(kept->num_gates() == 1);
+}
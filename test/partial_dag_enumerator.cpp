@@ -3,6 +3,7 @@
 //
 
 #include <enumeration_tool/enumerator_engines/partial_dag_enumerator.hpp>
+#include <enumeration_tool/enumerator_engines/partial_dag_enumerator_work_stealing.hpp>
 #include <enumeration_tool/enumerators/aig_enumerator.hpp>
 #include <mockturtle/algorithms/simulation.hpp>
 
@@ -40,6 +41,719 @@ TEST_CASE( "simulator", "[partial_dag_enumerator]" )
   en.enumerate_aig_pre_enumeration(generated);
 }
 
+TEST_CASE( "fixed-width truth tables", "[partial_dag_enumerator]" )
+{
+  using enumerator_t = enumeration_tool::partial_dag_enumerator<mockturtle::aig_network, mockturtle::aig_network::signal, EnumerationSymbols>;
+  using static_tt_t = kitty::static_truth_table<3>;
+  using static_enumerator_t = enumeration_tool::partial_dag_enumerator<mockturtle::aig_network, mockturtle::aig_network::signal, EnumerationSymbols, static_tt_t>;
+
+  int min_vertices = 1;
+  int max_vertices = 4;
+
+  std::vector<percy::partial_dag> generated = generate_dags(min_vertices, max_vertices);
+
+  std::vector<std::string> dynamic_functions;
+  std::vector<std::string> static_functions;
+
+  aig_enumeration_interface dynamic_store;
+  enumerator_t dynamic_en(dynamic_store.build_grammar(), std::make_shared<aig_enumeration_interface>(), [&](enumerator_t* enumerator) {
+    dynamic_functions.emplace_back(kitty::to_hex(enumerator->get_root_tt()));
+  });
+  dynamic_en.enumerate_aig_pre_enumeration(generated);
+
+  aig_enumeration_interface_t<static_tt_t> static_store;
+  static_enumerator_t static_en(static_store.build_grammar(), std::make_shared<aig_enumeration_interface_t<static_tt_t>>(), [&](static_enumerator_t* enumerator) {
+    static_functions.emplace_back(kitty::to_hex(enumerator->get_root_tt()));
+  });
+  static_en.enumerate_aig_pre_enumeration(generated);
+
+  REQUIRE(!dynamic_functions.empty());
+  REQUIRE(dynamic_functions == static_functions);
+  REQUIRE(dynamic_en.minimal_sizes.size() == static_en.minimal_sizes.size());
+}
+
+TEST_CASE( "gray code order", "[partial_dag_enumerator]" )
+{
+  using EnumerationType = mockturtle::aig_network;
+  using NodeType = mockturtle::aig_network::signal;
+  using SymbolType = EnumerationSymbols;
+  using enumerator_t = enumeration_tool::partial_dag_enumerator<mockturtle::aig_network, mockturtle::aig_network::signal, EnumerationSymbols>;
+
+  class test_enumerator : public enumerator_t {
+  public:
+    test_enumerator(const grammar<EnumerationType, NodeType, SymbolType>& symbols, std::shared_ptr<enumeration_interface<EnumerationType, NodeType, SymbolType>> interface)
+      : enumerator_t(symbols, interface, nullptr)
+    {}
+
+    void invoke_initialize(const percy::partial_dag& pdag) {
+      _dags.clear();
+      _dags.emplace_back(pdag);
+      _current_dag = 0;
+      initialize();
+    }
+
+    bool invoke_increase_stack_gray(unsigned position) {
+      return increase_stack_gray(position);
+    }
+  };
+
+  aig_enumeration_interface store;
+  test_enumerator en(store.build_grammar(), std::make_shared<aig_enumeration_interface>());
+
+  std::vector<percy::partial_dag> generated = generate_dags(1, 3);
+  for (const auto& pdag : generated) {
+    en.invoke_initialize(pdag);
+
+    std::vector<std::vector<int>> sequence;
+    sequence.emplace_back(en.get_current_assignment());
+    while (en.invoke_increase_stack_gray(0)) {
+      auto current = en.get_current_assignment();
+      int different = 0;
+      for (auto i = 0ul; i < current.size(); ++i) {
+        different += current[i] != sequence.back()[i] ? 1 : 0;
+      }
+      REQUIRE(different == 1);
+      sequence.emplace_back(current);
+    }
+
+    std::size_t expected_size = 1;
+    for (const auto& possible_assignment : en._possible_assignments) {
+      expected_size *= possible_assignment.size();
+    }
+    REQUIRE(sequence.size() == expected_size);
+    REQUIRE(std::set<std::vector<int>>(sequence.begin(), sequence.end()).size() == expected_size);
+
+    // a jump at position skips the remaining assignments sharing the slots >= position
+    for (auto t = 0ul; t < sequence.size(); ++t) {
+      for (auto position = 0u; position < sequence[t].size(); ++position) {
+        auto next = t + 1;
+        while (next < sequence.size() && std::equal(sequence[t].begin() + position, sequence[t].end(), sequence[next].begin() + position)) {
+          next++;
+        }
+
+        en.invoke_initialize(pdag);
+        for (auto k = 0ul; k < t; ++k) {
+          en.invoke_increase_stack_gray(0);
+        }
+        auto increased = en.invoke_increase_stack_gray(position);
+        REQUIRE(increased == (next < sequence.size()));
+        if (increased) {
+          REQUIRE(en.get_current_assignment() == sequence[next]);
+        }
+      }
+    }
+  }
+
+  std::vector<percy::partial_dag> larger = generate_dags(1, 4);
+
+  enumerator_t binary_en(store.build_grammar(), std::make_shared<aig_enumeration_interface>());
+  binary_en.enumerate_aig_pre_enumeration(larger);
+
+  enumerator_t gray_en(store.build_grammar(), std::make_shared<aig_enumeration_interface>());
+  gray_en.gray_code_order = true;
+  gray_en.enumerate_aig_pre_enumeration(larger);
+
+  REQUIRE(gray_en.minimal_sizes == binary_en.minimal_sizes);
+  // fewer resimulated nodes per candidate
+  REQUIRE(gray_en.simulated_nodes * binary_en.num_candidates < binary_en.simulated_nodes * gray_en.num_candidates);
+}
+
+TEST_CASE( "bit-sliced simulation", "[partial_dag_enumerator]" )
+{
+  using enumerator_t = enumeration_tool::partial_dag_enumerator<mockturtle::aig_network, mockturtle::aig_network::signal, EnumerationSymbols>;
+
+  std::vector<percy::partial_dag> generated = generate_dags(1, 4);
+
+  std::vector<std::string> scalar_functions;
+  std::vector<std::string> bit_sliced_functions;
+
+  aig_enumeration_interface store;
+  enumerator_t scalar_en(store.build_grammar(), std::make_shared<aig_enumeration_interface>(), [&](enumerator_t* enumerator) {
+    scalar_functions.emplace_back(kitty::to_hex(enumerator->get_root_tt()));
+  });
+  scalar_en.enumerate_aig_pre_enumeration(generated);
+
+  enumerator_t bit_sliced_en(store.build_grammar(), std::make_shared<aig_enumeration_interface>(), [&](enumerator_t* enumerator) {
+    bit_sliced_functions.emplace_back(kitty::to_hex(enumerator->get_root_tt()));
+  });
+  bit_sliced_en.bit_sliced_simulation = true;
+  bit_sliced_en.enumerate_aig_pre_enumeration(generated);
+
+  REQUIRE(!scalar_functions.empty());
+  REQUIRE(bit_sliced_functions == scalar_functions);
+  REQUIRE(bit_sliced_en.minimal_sizes == scalar_en.minimal_sizes);
+
+  // the same node TTs, each taken from a lane, from fewer node operations
+  REQUIRE(scalar_en.bit_sliced_nodes == 0);
+  REQUIRE(bit_sliced_en.simulated_nodes == scalar_en.simulated_nodes);
+  REQUIRE(bit_sliced_en.bit_sliced_nodes > 0);
+  REQUIRE(bit_sliced_en.bit_sliced_nodes < bit_sliced_en.simulated_nodes);
+}
+
+TEST_CASE( "in-place node operations", "[partial_dag_enumerator]" )
+{
+  using enumerator_t = enumeration_tool::partial_dag_enumerator<mockturtle::aig_network, mockturtle::aig_network::signal, EnumerationSymbols>;
+
+  class allocating_interface : public aig_enumeration_interface {
+  public:
+    auto get_node_operation_inplace(SymbolType) -> node_operation_inplace_callback_fn override { return nullptr; }
+  };
+
+  std::vector<percy::partial_dag> generated = generate_dags(1, 4);
+
+  std::vector<std::string> inplace_functions;
+  std::vector<std::string> allocating_functions;
+
+  aig_enumeration_interface inplace_store;
+  enumerator_t inplace_en(inplace_store.build_grammar(), std::make_shared<aig_enumeration_interface>(), [&](enumerator_t* enumerator) {
+    inplace_functions.emplace_back(kitty::to_hex(enumerator->get_root_tt()));
+  });
+  inplace_en.enumerate_aig_pre_enumeration(generated);
+
+  allocating_interface allocating_store;
+  enumerator_t allocating_en(allocating_store.build_grammar(), std::make_shared<allocating_interface>(), [&](enumerator_t* enumerator) {
+    allocating_functions.emplace_back(kitty::to_hex(enumerator->get_root_tt()));
+  });
+  allocating_en.enumerate_aig_pre_enumeration(generated);
+
+  REQUIRE(inplace_en.simulated_nodes > 0);
+  REQUIRE(inplace_en.allocating_node_operations == 0);
+  REQUIRE(allocating_en.allocating_node_operations == allocating_en.simulated_nodes);
+  REQUIRE(inplace_functions == allocating_functions);
+}
+
+TEST_CASE( "compile-time grammar", "[partial_dag_enumerator]" )
+{
+  using enumerator_t = enumeration_tool::partial_dag_enumerator<mockturtle::aig_network, mockturtle::aig_network::signal, EnumerationSymbols>;
+  using static_enumerator_t = enumeration_tool::partial_dag_enumerator<mockturtle::aig_network, mockturtle::aig_network::signal, EnumerationSymbols, kitty::dynamic_truth_table, aig_grammar_description>;
+  using static_interface_t = static_enumeration_interface<aig_grammar_description>;
+
+  static_assert(find_static_symbol<aig_grammar_description>(And).attributes.is_set(enumeration_attributes::commutative));
+  static_assert(num_static_terminal_symbols<aig_grammar_description>() == 3);
+
+  const int var_num = 3;
+  mockturtle::default_simulator<kitty::dynamic_truth_table> sim(var_num);
+
+  std::vector<percy::partial_dag> generated = generate_dags(1, 4);
+
+  std::vector<std::string> runtime_functions;
+  std::vector<std::string> static_functions;
+
+  aig_enumeration_interface runtime_store;
+  enumerator_t runtime_en(runtime_store.build_grammar(), std::make_shared<aig_enumeration_interface>(), [&](enumerator_t* enumerator) {
+    runtime_functions.emplace_back(kitty::to_hex(enumerator->get_root_tt()));
+  });
+  runtime_en.enumerate_aig_pre_enumeration(generated);
+
+  static_interface_t static_store;
+  static_enumerator_t static_en(static_store.build_grammar(), std::make_shared<static_interface_t>(), [&](static_enumerator_t* enumerator) {
+    static_functions.emplace_back(kitty::to_hex(enumerator->get_root_tt()));
+    const auto tt = mockturtle::simulate<kitty::dynamic_truth_table>(*(enumerator->to_enumeration_type()), sim);
+    REQUIRE(kitty::to_hex(tt[0]) == static_functions.back());
+  });
+  static_en.enumerate_aig_pre_enumeration(generated);
+
+  REQUIRE(!runtime_functions.empty());
+  REQUIRE(static_functions == runtime_functions);
+  REQUIRE(static_en.minimal_sizes == runtime_en.minimal_sizes);
+  REQUIRE(static_en.allocating_node_operations == 0);
+}
+
+TEST_CASE( "multi-target enumeration", "[partial_dag_enumerator]" )
+{
+  using enumerator_t = enumeration_tool::partial_dag_enumerator<mockturtle::aig_network, mockturtle::aig_network::signal, EnumerationSymbols>;
+
+  const int var_num = 3;
+  mockturtle::default_simulator<kitty::dynamic_truth_table> sim(var_num);
+
+  std::vector<percy::partial_dag> generated = generate_dags(1, 4);
+
+  aig_enumeration_interface store;
+  enumerator_t full_en(store.build_grammar(), std::make_shared<aig_enumeration_interface>());
+  full_en.enumerate_aig_pre_enumeration(generated);
+
+  enumerator_t all_en(store.build_grammar(), std::make_shared<aig_enumeration_interface>());
+  all_en.set_all_targets();
+  all_en.enumerate_aig_pre_enumeration(generated);
+
+  REQUIRE(!all_en.all_targets_covered());
+  REQUIRE(all_en.target_solutions.size() == full_en.minimal_sizes.size());
+  for (const auto& [tt, solution] : all_en.target_solutions) {
+    REQUIRE(solution.nr_gates == full_en.minimal_sizes.at(tt));
+
+    all_en.load_target_solution(generated, solution);
+    REQUIRE(all_en.get_root_tt() == tt);
+    REQUIRE(mockturtle::simulate<kitty::dynamic_truth_table>(*(all_en.to_enumeration_type()), sim)[0] == tt);
+  }
+
+  std::vector<kitty::dynamic_truth_table> targets;
+  for (const auto& [tt, size] : full_en.minimal_sizes) {
+    if (size <= 1) {
+      targets.emplace_back(tt);
+    }
+  }
+
+  enumerator_t targets_en(store.build_grammar(), std::make_shared<aig_enumeration_interface>());
+  targets_en.set_targets(targets);
+  targets_en.enumerate_aig_pre_enumeration(generated);
+
+  REQUIRE(targets_en.all_targets_covered());
+  // stops once the targets are covered
+  REQUIRE(targets_en.num_candidates < full_en.num_candidates);
+}
+
+TEST_CASE( "NPN pruning", "[partial_dag_enumerator]" )
+{
+  using enumerator_t = enumeration_tool::partial_dag_enumerator<mockturtle::aig_network, mockturtle::aig_network::signal, EnumerationSymbols>;
+
+  std::vector<percy::partial_dag> generated = generate_dags(1, 5);
+
+  aig_enumeration_interface store;
+  enumerator_t plain_en(store.build_grammar(), std::make_shared<aig_enumeration_interface>());
+  plain_en.enumerate_aig_pre_enumeration(generated);
+
+  enumerator_t npn_en(store.build_grammar(), std::make_shared<aig_enumeration_interface>());
+  npn_en.npn_pruning = true;
+  npn_en.enumerate_aig_pre_enumeration(generated);
+
+  REQUIRE(npn_en.minimal_sizes == plain_en.minimal_sizes);
+  REQUIRE(npn_en.num_candidates < plain_en.num_candidates);
+
+  enumerator_t classes_en(store.build_grammar(), std::make_shared<aig_enumeration_interface>());
+  classes_en.set_all_targets(true);
+  classes_en.enumerate_aig_pre_enumeration(generate_dags(1, 6));
+
+  REQUIRE(classes_en.all_targets_covered());
+  REQUIRE(classes_en.target_solutions.size() == 14);
+}
+
+TEST_CASE( "minimum size database warm start", "[partial_dag_enumerator]" )
+{
+  using enumerator_t = enumeration_tool::partial_dag_enumerator<mockturtle::aig_network, mockturtle::aig_network::signal, EnumerationSymbols>;
+
+  const std::string filename = "test_warm_start.db";
+  std::remove(filename.c_str());
+
+  std::vector<percy::partial_dag> generated = generate_dags(1, 4);
+  aig_enumeration_interface store;
+
+  enumerator_t cold_en(store.build_grammar(), std::make_shared<aig_enumeration_interface>());
+  cold_en.database = std::make_shared<enumeration_tool::minimum_size_database>(filename);
+  cold_en.enumerate_aig_pre_enumeration(generated);
+  REQUIRE(cold_en.database->size() == cold_en.minimal_sizes.size());
+
+  enumerator_t warm_en(store.build_grammar(), std::make_shared<aig_enumeration_interface>());
+  warm_en.database = std::make_shared<enumeration_tool::minimum_size_database>(filename);
+  warm_en.enumerate_aig_pre_enumeration(generated);
+  REQUIRE(warm_en.minimal_sizes == cold_en.minimal_sizes);
+
+  // on the 4-gate DAGs alone, the stored sizes of the smaller functions prune cones that a run without database has to enumerate
+  std::vector<percy::partial_dag> four_gates;
+  std::copy_if(generated.begin(), generated.end(), std::back_inserter(four_gates), [](const auto& pdag) { return pdag.nr_gates_vertices == 4; });
+  REQUIRE(!four_gates.empty());
+
+  enumerator_t no_database_en(store.build_grammar(), std::make_shared<aig_enumeration_interface>());
+  no_database_en.enumerate_aig_pre_enumeration(four_gates);
+
+  enumerator_t database_en(store.build_grammar(), std::make_shared<aig_enumeration_interface>());
+  database_en.database = std::make_shared<enumeration_tool::minimum_size_database>(filename);
+  database_en.enumerate_aig_pre_enumeration(four_gates);
+  REQUIRE(database_en.simulation_duplicates > no_database_en.simulation_duplicates);
+  REQUIRE(database_en.num_candidates < no_database_en.num_candidates);
+
+  // the witnesses rebuild the functions
+  for (const auto& [tt, size] : cold_en.minimal_sizes) {
+    auto record = warm_en.database->find(tt);
+    REQUIRE(record);
+    REQUIRE(record->size == size);
+    warm_en.load_target_solution(generated, {record->dag_index, record->assignment, record->size});
+    REQUIRE(warm_en.get_root_tt() == tt);
+  }
+
+  std::remove(filename.c_str());
+}
+
+TEST_CASE( "checkpoint and resume", "[partial_dag_enumerator]" )
+{
+  using enumerator_t = enumeration_tool::partial_dag_enumerator<mockturtle::aig_network, mockturtle::aig_network::signal, EnumerationSymbols>;
+
+  const std::string filename = "test_checkpoint.cbor";
+  std::remove(filename.c_str());
+
+  std::vector<percy::partial_dag> generated = generate_dags(1, 4);
+  aig_enumeration_interface store;
+
+  std::vector<std::vector<int>> full_sequence;
+  enumerator_t full_en(store.build_grammar(), std::make_shared<aig_enumeration_interface>(), [&](enumerator_t* en) {
+    full_sequence.emplace_back(en->get_current_assignment());
+  });
+  full_en.enumerate_aig_pre_enumeration(generated);
+  REQUIRE(full_sequence.size() > 100);
+
+  // a checkpoint before every candidate, the run is interrupted in the middle
+  std::vector<std::vector<int>> sequence;
+  enumerator_t interrupted_en(store.build_grammar(), std::make_shared<aig_enumeration_interface>());
+  interrupted_en._use_formula_callback = [&](enumerator_t*) {
+    sequence.emplace_back(interrupted_en.get_current_assignment());
+    if (sequence.size() == full_sequence.size() / 2) {
+      interrupted_en.stop();
+    }
+  };
+  interrupted_en.checkpoint_filename = filename;
+  interrupted_en.checkpoint_interval = std::chrono::milliseconds(0);
+  interrupted_en.checkpoint_period = 1;
+  interrupted_en.enumerate_aig_pre_enumeration(generated);
+
+  // the last candidate is processed again
+  auto checkpoint = enumeration_tool::enumeration_checkpoint::load(filename);
+  sequence.pop_back();
+  enumerator_t resumed_en(store.build_grammar(), std::make_shared<aig_enumeration_interface>(), [&](enumerator_t* en) {
+    sequence.emplace_back(en->get_current_assignment());
+  });
+  resumed_en.resume(generated, checkpoint);
+
+  REQUIRE(sequence == full_sequence);
+  REQUIRE(resumed_en.minimal_sizes == full_en.minimal_sizes);
+
+  std::remove(filename.c_str());
+}
+
+TEST_CASE( "parallel checkpoint and resume", "[partial_dag_enumerator]" )
+{
+  using parallel_t = enumeration_tool::partial_dag_enumerator_parallel<mockturtle::aig_network, mockturtle::aig_network::signal, EnumerationSymbols>;
+  using enumeration_tool::enumeration_checkpoint;
+  using enumeration_tool::enumeration_status;
+
+  const std::string filename = "test_parallel_checkpoint.cbor";
+  std::remove(filename.c_str());
+
+  std::vector<percy::partial_dag> raw_dags;
+  for (int i = 1; i <= 4; ++i) { // the parallel engines add the inputs to the DAGs by themselves
+    auto dags = percy::pd_generate_nonisomorphic(i);
+    raw_dags.insert(raw_dags.end(), dags.begin(), dags.end());
+  }
+  aig_enumeration_interface store;
+
+  std::atomic<unsigned> num_calls = 0;
+  parallel_t full_en(store.build_grammar(), std::make_shared<aig_enumeration_interface>());
+  full_en._use_candidate_callback = [&](const parallel_t::candidate_view&) {
+    num_calls++;
+    return false;
+  };
+  full_en.enumerate_aig_pre_enumeration(raw_dags, 3);
+  REQUIRE(num_calls > 1000);
+
+  // one candidate at a time, then claimed blocks
+  for (auto max_block_size : {1ul, 64ul}) {
+    // the run is stopped in the middle, once a checkpoint has the candidate of the callback in flight
+    std::atomic<unsigned> calls = 0;
+    std::optional<enumeration_checkpoint> checkpoint;
+    parallel_t interrupted_en(store.build_grammar(), std::make_shared<aig_enumeration_interface>());
+    interrupted_en._use_candidate_callback = [&](const parallel_t::candidate_view& candidate) {
+      if (++calls != num_calls / 2) {
+        return false;
+      }
+      std::pair<int, std::vector<int>> current(candidate.pdag_index, candidate.assignment);
+      while (!checkpoint) {
+        try {
+          auto written = enumeration_checkpoint::load(filename);
+          if (std::find(written.in_flight.begin(), written.in_flight.end(), current) != written.in_flight.end()) {
+            checkpoint = std::move(written);
+          }
+        } catch (const std::runtime_error&) {} // not written yet
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+      return true;
+    };
+    interrupted_en.min_block_size = 4;
+    interrupted_en.max_block_size = max_block_size;
+    interrupted_en.checkpoint_filename = filename;
+    interrupted_en.checkpoint_interval = std::chrono::milliseconds(1);
+    interrupted_en.enumerate_aig_pre_enumeration(raw_dags, 3);
+    REQUIRE(interrupted_en.status == enumeration_status::stopped);
+    REQUIRE(checkpoint);
+    REQUIRE(!checkpoint->in_flight.empty());
+
+    parallel_t resumed_en(store.build_grammar(), std::make_shared<aig_enumeration_interface>());
+    resumed_en._use_candidate_callback = [](const parallel_t::candidate_view&) { return false; };
+    resumed_en.min_block_size = 4;
+    resumed_en.max_block_size = max_block_size;
+    resumed_en.resume(raw_dags, *checkpoint, 3);
+    REQUIRE(resumed_en.status == enumeration_status::completed);
+    REQUIRE(resumed_en.minimal_sizes == full_en.minimal_sizes);
+
+    std::remove(filename.c_str());
+  }
+}
+
+TEST_CASE( "enumeration limits", "[partial_dag_enumerator]" )
+{
+  using enumerator_t = enumeration_tool::partial_dag_enumerator<mockturtle::aig_network, mockturtle::aig_network::signal, EnumerationSymbols>;
+  using parallel_t = enumeration_tool::partial_dag_enumerator_parallel<mockturtle::aig_network, mockturtle::aig_network::signal, EnumerationSymbols>;
+  using enumeration_tool::enumeration_status;
+
+  aig_enumeration_interface store;
+  std::vector<percy::partial_dag> generated = generate_dags(1, 4);
+
+  enumerator_t full_en(store.build_grammar(), std::make_shared<aig_enumeration_interface>());
+  full_en.enumerate_aig_pre_enumeration(generated);
+  REQUIRE(full_en.status == enumeration_status::completed);
+  REQUIRE(full_en.num_candidates > 1000);
+
+  enumerator_t budget_en(store.build_grammar(), std::make_shared<aig_enumeration_interface>());
+  budget_en.limits.max_candidates = 1000;
+  budget_en.limits.check_period = 100;
+  budget_en.enumerate_aig_pre_enumeration(generated);
+  REQUIRE(budget_en.status == enumeration_status::budget_exhausted);
+  REQUIRE(budget_en.num_candidates == 1000);
+
+  enumerator_t every_candidate_en(store.build_grammar(), std::make_shared<aig_enumeration_interface>());
+  every_candidate_en.limits.max_candidates = 1000;
+  every_candidate_en.limits.check_period = 0; // checked on every candidate
+  every_candidate_en.enumerate_aig_pre_enumeration(generated);
+  REQUIRE(every_candidate_en.status == enumeration_status::budget_exhausted);
+  REQUIRE(every_candidate_en.num_candidates == 1000);
+
+  enumerator_t timeout_en(store.build_grammar(), std::make_shared<aig_enumeration_interface>());
+  timeout_en.limits.set_timeout(std::chrono::seconds(0));
+  timeout_en.enumerate_aig_pre_enumeration(generated);
+  REQUIRE(timeout_en.status == enumeration_status::timeout);
+  REQUIRE(timeout_en.num_candidates == 0);
+
+  // cancelled from the callback, through a copy of the token
+  auto token = full_en.limits.token;
+  enumerator_t cancelled_en(store.build_grammar(), std::make_shared<aig_enumeration_interface>(), [&](enumerator_t* en) {
+    if (en->num_candidates == 500) {
+      token.cancel();
+    }
+  });
+  cancelled_en.limits.token = token;
+  cancelled_en.limits.check_period = 10;
+  cancelled_en.enumerate_aig_pre_enumeration(generated);
+  REQUIRE(cancelled_en.status == enumeration_status::cancelled);
+  REQUIRE(cancelled_en.num_candidates < full_en.num_candidates);
+
+  std::vector<percy::partial_dag> raw_dags;
+  for (int i = 1; i <= 4; ++i) { // the parallel engines add the inputs to the DAGs by themselves
+    auto dags = percy::pd_generate_nonisomorphic(i);
+    raw_dags.insert(raw_dags.end(), dags.begin(), dags.end());
+  }
+  parallel_t parallel_en(store.build_grammar(), std::make_shared<aig_enumeration_interface>());
+  parallel_en._use_candidate_callback = [](const parallel_t::candidate_view&) { return false; };
+  parallel_en.enumerate_aig_pre_enumeration(raw_dags, 2);
+  REQUIRE(parallel_en.status == enumeration_status::completed);
+
+  parallel_t parallel_budget_en(store.build_grammar(), std::make_shared<aig_enumeration_interface>());
+  parallel_budget_en._use_candidate_callback = [](const parallel_t::candidate_view&) { return false; };
+  parallel_budget_en.limits.max_candidates = 1000;
+  parallel_budget_en.limits.check_period = 10;
+  parallel_budget_en.enumerate_aig_pre_enumeration(raw_dags, 2);
+  REQUIRE(parallel_budget_en.status == enumeration_status::budget_exhausted);
+  REQUIRE(parallel_budget_en.num_candidates >= 1000);
+  REQUIRE(parallel_budget_en.num_candidates < parallel_en.num_candidates);
+
+  parallel_t parallel_every_candidate_en(store.build_grammar(), std::make_shared<aig_enumeration_interface>());
+  parallel_every_candidate_en._use_candidate_callback = [](const parallel_t::candidate_view&) { return false; };
+  parallel_every_candidate_en.limits.max_candidates = 1000;
+  parallel_every_candidate_en.limits.check_period = 0;
+  parallel_every_candidate_en.enumerate_aig_pre_enumeration(raw_dags, 2);
+  REQUIRE(parallel_every_candidate_en.status == enumeration_status::budget_exhausted);
+  REQUIRE(parallel_every_candidate_en.num_candidates >= 1000);
+  REQUIRE(parallel_every_candidate_en.num_candidates < parallel_en.num_candidates);
+
+  parallel_t parallel_stopped_en(store.build_grammar(), std::make_shared<aig_enumeration_interface>());
+  parallel_stopped_en._use_candidate_callback = [](const parallel_t::candidate_view&) { return true; };
+  parallel_stopped_en.limits.set_timeout(std::chrono::hours(1));
+  parallel_stopped_en.enumerate_aig_pre_enumeration(raw_dags, 2);
+  REQUIRE(parallel_stopped_en.status == enumeration_status::stopped);
+}
+
+TEST_CASE( "parallel engines", "[partial_dag_enumerator]" )
+{
+  using parallel_t = enumeration_tool::partial_dag_enumerator_parallel<mockturtle::aig_network, mockturtle::aig_network::signal, EnumerationSymbols>;
+  using work_stealing_t = enumeration_tool::partial_dag_enumerator_work_stealing<mockturtle::aig_network, mockturtle::aig_network::signal, EnumerationSymbols>;
+
+  const int var_num = 3;
+  std::vector<percy::partial_dag> generated;
+  for (int i = 1; i <= 4; ++i) { // the parallel engines add the inputs to the DAGs by themselves
+    auto dags = percy::pd_generate_nonisomorphic(i);
+    generated.insert(generated.end(), dags.begin(), dags.end());
+  }
+
+  aig_enumeration_interface store;
+  std::atomic<int> num_mismatches = 0;
+  auto check_view = [&](const parallel_t::candidate_view& candidate) {
+    mockturtle::default_simulator<kitty::dynamic_truth_table> sim(var_num);
+    if (mockturtle::simulate<kitty::dynamic_truth_table>(*(candidate.to_enumeration_type()), sim)[0] != candidate.root_tt()) {
+      num_mismatches++;
+    }
+    return false;
+  };
+
+  parallel_t parallel_en(store.build_grammar(), std::make_shared<aig_enumeration_interface>());
+  parallel_en._use_candidate_callback = check_view;
+  parallel_en.enumerate_aig_pre_enumeration(generated, 2);
+  REQUIRE(num_mismatches == 0);
+  REQUIRE(parallel_en.minimal_sizes.size() > 100);
+
+  work_stealing_t work_stealing_en(store.build_grammar(), std::make_shared<aig_enumeration_interface>());
+  work_stealing_en._use_candidate_callback = check_view;
+  work_stealing_en.enumerate_aig_pre_enumeration(generated, 3);
+  REQUIRE(num_mismatches == 0);
+  REQUIRE(work_stealing_en.minimal_sizes == parallel_en.minimal_sizes);
+
+  parallel_t block_en(store.build_grammar(), std::make_shared<aig_enumeration_interface>());
+  block_en._use_candidate_callback = check_view;
+  block_en.min_block_size = 4;
+  block_en.max_block_size = 64;
+  block_en.enumerate_aig_pre_enumeration(generated, 3);
+  REQUIRE(num_mismatches == 0);
+  REQUIRE(block_en.minimal_sizes == parallel_en.minimal_sizes);
+
+  // full tables do not stop the run: the duplicates are no longer accumulated, the minimal sizes overflow
+  parallel_t small_table_en(store.build_grammar(), std::make_shared<aig_enumeration_interface>());
+  small_table_en._use_candidate_callback = check_view;
+  small_table_en.table_capacity = 16;
+  small_table_en.enumerate_aig_pre_enumeration(generated, 2);
+  REQUIRE(small_table_en.minimal_sizes == parallel_en.minimal_sizes);
+
+  // the simulation pruning only skips non-minimal candidates
+  parallel_t unpruned_en(store.build_grammar(), std::make_shared<aig_enumeration_interface>());
+  unpruned_en._use_candidate_callback = check_view;
+  unpruned_en.simulation_pruning = false;
+  unpruned_en.enumerate_aig_pre_enumeration(generated, 2);
+  REQUIRE(unpruned_en.minimal_sizes == parallel_en.minimal_sizes);
+
+  // the duplicate accumulation on the mined patterns only skips non-minimal candidates; on one thread the number of
+  // candidates does not depend on the timing of the other threads
+  parallel_t mined_en(store.build_grammar(), std::make_shared<aig_enumeration_interface>());
+  mined_en._use_candidate_callback = check_view;
+  mined_en.simulation_pruning = false;
+  mined_en.enumerate_aig_pre_enumeration(generated, 1);
+  REQUIRE(mined_en.minimal_sizes == parallel_en.minimal_sizes);
+
+  parallel_t unmined_en(store.build_grammar(), std::make_shared<aig_enumeration_interface>());
+  unmined_en._use_candidate_callback = check_view;
+  unmined_en.simulation_pruning = false;
+  unmined_en.subgraph_mining = false;
+  unmined_en.enumerate_aig_pre_enumeration(generated, 1);
+  REQUIRE(unmined_en.minimal_sizes == parallel_en.minimal_sizes);
+  REQUIRE(unmined_en.num_candidates.load() > mined_en.num_candidates.load());
+
+  // the callbacks on their own threads, through a small queue
+  parallel_t pipelined_en(store.build_grammar(), std::make_shared<aig_enumeration_interface>());
+  pipelined_en._use_candidate_callback = check_view;
+  pipelined_en.verifier_threads = 2;
+  pipelined_en.pipeline_depth = 16;
+  pipelined_en.enumerate_aig_pre_enumeration(generated, 2);
+  REQUIRE(num_mismatches == 0);
+  REQUIRE(pipelined_en.minimal_sizes == parallel_en.minimal_sizes);
+
+  // the same winner and the same tables for any number of workers
+  auto target = std::max_element(parallel_en.minimal_sizes.begin(), parallel_en.minimal_sizes.end(), [](const auto& a, const auto& b) {
+    return std::make_pair(a.second, a.first) < std::make_pair(b.second, b.first);
+  })->first;
+  auto deterministic_run = [&](int num_workers) {
+    work_stealing_t en(store.build_grammar(), std::make_shared<aig_enumeration_interface>());
+    en.deterministic = true;
+    en.chunk_size = 100;
+    en._use_candidate_callback = [&](const parallel_t::candidate_view& candidate) {
+      return candidate.root_tt() == target;
+    };
+    en.enumerate_aig_pre_enumeration(generated, num_workers);
+    return std::make_pair(en.current_solution, en.minimal_sizes);
+  };
+  auto reference = deterministic_run(1);
+  REQUIRE(!reference.first.empty());
+  REQUIRE(deterministic_run(2) == reference);
+  REQUIRE(deterministic_run(4) == reference);
+
+  // the pruning of a group does not depend on the timing of the commits
+  auto deterministic_count = [&](int num_workers) {
+    work_stealing_t en(store.build_grammar(), std::make_shared<aig_enumeration_interface>());
+    en.deterministic = true;
+    en.chunk_size = 100;
+    en._use_candidate_callback = [](const parallel_t::candidate_view&) { return false; };
+    en.enumerate_aig_pre_enumeration(generated, num_workers);
+    return std::make_pair(en.num_candidates.load(), en.minimal_sizes);
+  };
+  auto reference_count = deterministic_count(1);
+  REQUIRE(reference_count.second == parallel_en.minimal_sizes);
+  REQUIRE(deterministic_count(2) == reference_count);
+  REQUIRE(deterministic_count(4) == reference_count);
+
+  // the simulation pruning without a candidate callback
+  parallel_t formula_en(store.build_grammar(), std::make_shared<aig_enumeration_interface>(), [](parallel_t*, const std::shared_ptr<mockturtle::aig_network>&) {
+    return parallel_t::callback_result{};
+  });
+  formula_en.enumerate_aig_pre_enumeration(generated, 2);
+  REQUIRE(formula_en.minimal_sizes == parallel_en.minimal_sizes);
+}
+
+TEST_CASE( "fanout-free cones", "[partial_dag_enumerator]" )
+{
+  using parallel_t = enumeration_tool::partial_dag_enumerator_parallel<mockturtle::aig_network, mockturtle::aig_network::signal, EnumerationSymbols>;
+
+  class test_enumerator : public parallel_t {
+  public:
+    using parallel_t::is_fanout_free;
+  };
+
+  // the cone of vertex 3 is {0, 1, 3}
+  std::vector<bool> in_cone{true, true, false, true, false};
+  REQUIRE(test_enumerator::is_fanout_free({{0, 0}, {0, 0}, {0, 0}, {1, 2}, {4, 3}}, in_cone, 3));
+  // leaf 1 is also read by vertex 4, outside of the cone
+  REQUIRE_FALSE(test_enumerator::is_fanout_free({{0, 0}, {0, 0}, {0, 0}, {1, 2}, {4, 2}}, in_cone, 3));
+}
+
+TEST_CASE( "deterministic work stealing as the serial engine", "[partial_dag_enumerator]" )
+{
+  using enumerator_t = enumeration_tool::partial_dag_enumerator<mockturtle::aig_network, mockturtle::aig_network::signal, EnumerationSymbols>;
+  using parallel_t = enumeration_tool::partial_dag_enumerator_parallel<mockturtle::aig_network, mockturtle::aig_network::signal, EnumerationSymbols>;
+  using work_stealing_t = enumeration_tool::partial_dag_enumerator_work_stealing<mockturtle::aig_network, mockturtle::aig_network::signal, EnumerationSymbols>;
+
+  std::vector<percy::partial_dag> generated = generate_dags(1, 4);
+  aig_enumeration_interface store;
+
+  // the last function found by the serial engine, most of the DAGs come before it
+  kitty::dynamic_truth_table target;
+  auto num_functions = 0ul;
+  enumerator_t full_en(store.build_grammar(), std::make_shared<aig_enumeration_interface>(), [&](enumerator_t* enumerator) {
+    if (enumerator->minimal_sizes.size() > num_functions) {
+      num_functions = enumerator->minimal_sizes.size();
+      target = enumerator->get_root_tt();
+    }
+  });
+  full_en.enumerate_aig_pre_enumeration(generated);
+
+  std::string serial_solution;
+  enumerator_t serial_en(store.build_grammar(), std::make_shared<aig_enumeration_interface>(), [&](enumerator_t* enumerator) {
+    if (enumerator->get_root_tt() == target) {
+      serial_solution = enumerator->get_current_solution();
+      enumerator->stop();
+    }
+  });
+  serial_en.enumerate_aig_pre_enumeration(generated);
+  REQUIRE(!serial_solution.empty());
+
+  for (auto num_workers : {1, 2, 4}) {
+    work_stealing_t en(store.build_grammar(), std::make_shared<aig_enumeration_interface>());
+    en.deterministic = true;
+    en.chunk_size = 100;
+    en._use_candidate_callback = [&](const parallel_t::candidate_view& candidate) {
+      return candidate.root_tt() == target;
+    };
+    en.enumerate_aig_pre_enumeration(generated, num_workers);
+
+    REQUIRE(en.current_solution == serial_solution);
+    REQUIRE(en.num_candidates.load() == serial_en.num_candidates);
+    REQUIRE(en.minimal_sizes.size() == serial_en.minimal_sizes.size());
+    for (const auto& [tt, size] : serial_en.minimal_sizes) {
+      REQUIRE(en.minimal_sizes.at(tt) == static_cast<unsigned>(size));
+    }
+  }
+}
+
 TEST_CASE( "get_minimal_index", "[partial_dag_enumerator]" )
 {
   using EnumerationType = mockturtle::aig_network;
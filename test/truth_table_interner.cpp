@@ -0,0 +1,81 @@
+#include <enumeration_tool/truth_table_interner.hpp>
+
+#include "catch2/catch.hpp"
+
+#include <kitty/constructors.hpp>
+#include <kitty/dynamic_truth_table.hpp>
+#include <kitty/operations.hpp>
+#include <kitty/static_truth_table.hpp>
+
+TEST_CASE( "equal truth tables get the same ID", "[truth_table_interner]" )
+{
+  enumeration_tool::truth_table_interner<kitty::dynamic_truth_table> interner(7);
+  kitty::dynamic_truth_table a(7), b(7);
+  kitty::create_nth_var(a, 0);
+  kitty::create_nth_var(b, 6);
+
+  REQUIRE(interner.find(a) == interner.npos);
+  auto id_a = interner.intern(a);
+  auto id_b = interner.intern(b);
+  REQUIRE(id_a == 0);
+  REQUIRE(id_b == 1);
+  REQUIRE(interner.intern(a) == id_a);
+  REQUIRE(interner.find(b) == id_b);
+  REQUIRE(interner.find(a & b) == interner.npos);
+  REQUIRE(interner.size() == 2);
+  REQUIRE(interner.truth_table(id_b) == b);
+}
+
+TEST_CASE( "IDs are stable when the index grows", "[truth_table_interner]" )
+{
+  enumeration_tool::truth_table_interner<kitty::static_truth_table<5>> interner(5);
+  kitty::static_truth_table<5> tt;
+  for (auto i = 0u; i < 4096u; ++i) {
+    kitty::create_from_words(tt, &i, &i + 1);
+    REQUIRE(interner.intern(tt) == i);
+  }
+  REQUIRE(interner.size() == 4096);
+  for (auto i = 0u; i < 4096u; i += 97u) {
+    kitty::create_from_words(tt, &i, &i + 1);
+    REQUIRE(interner.find(tt) == i);
+    REQUIRE(interner.truth_table(i) == tt);
+  }
+}
+
+TEST_CASE( "up to 4 inputs the ID is the truth table", "[truth_table_interner]" )
+{
+  enumeration_tool::truth_table_interner<kitty::dynamic_truth_table> interner(4);
+  REQUIRE(interner.is_direct());
+  REQUIRE(interner.size() == 65536);
+  REQUIRE_FALSE(enumeration_tool::truth_table_interner<kitty::dynamic_truth_table>(5).is_direct());
+
+  kitty::dynamic_truth_table a(4), b(4);
+  kitty::create_nth_var(a, 1);
+  kitty::create_nth_var(b, 3);
+  REQUIRE(interner.find(a & b) == 0xcc00);
+  REQUIRE(interner.intern(a & b) == 0xcc00);
+  REQUIRE(interner.intern(~a) == 0x3333);
+  REQUIRE(interner.truth_table(0x3333) == ~a);
+}
+
+TEST_CASE( "id_map keeps the first value and forgets on clear", "[truth_table_interner]" )
+{
+  enumeration_tool::id_map<int> map;
+  REQUIRE(map.find(3) == nullptr);
+  REQUIRE(map.emplace(3, 10));
+  REQUIRE_FALSE(map.emplace(3, 20));
+  REQUIRE(*map.find(3) == 10);
+  REQUIRE(map.emplace(5000, 1));
+  REQUIRE(map.contains(5000));
+
+  map.erase(3);
+  REQUIRE_FALSE(map.contains(3));
+  REQUIRE(map.emplace(3, 30));
+  REQUIRE(*map.find(3) == 30);
+
+  map.clear();
+  REQUIRE_FALSE(map.contains(3));
+  REQUIRE_FALSE(map.contains(5000));
+  REQUIRE(map.emplace(5000, 2));
+  REQUIRE(*map.find(5000) == 2);
+}
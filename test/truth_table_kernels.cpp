@@ -0,0 +1,98 @@
+#include <enumeration_tool/truth_table_kernels.hpp>
+
+#include "catch2/catch.hpp"
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace {
+
+using enumeration_tool::kernels::instruction_set;
+
+auto random_words(std::mt19937_64& rng, std::size_t num_words) -> std::vector<uint64_t>
+{
+  std::vector<uint64_t> words(num_words);
+  for (auto& word : words) {
+    word = rng();
+  }
+  return words;
+}
+
+// the instruction sets this CPU can run, from the portable one up
+auto instruction_sets() -> std::vector<instruction_set>
+{
+  std::vector<instruction_set> sets = { instruction_set::portable };
+  for (auto set : { instruction_set::avx2, instruction_set::avx512 }) {
+    if (static_cast<int>(set) <= static_cast<int>(enumeration_tool::kernels::supported_instruction_set())) {
+      sets.push_back(set);
+    }
+  }
+  return sets;
+}
+
+} // namespace
+
+TEST_CASE( "kernels on all instruction sets", "[truth_table_kernels]" )
+{
+  namespace kernels = enumeration_tool::kernels;
+  std::mt19937_64 rng(42);
+  const auto initial = kernels::active_instruction_set();
+
+  for (auto set : instruction_sets()) {
+    kernels::use_instruction_set(set);
+    REQUIRE(kernels::active_instruction_set() == set);
+
+    for (std::size_t num_words : { 1u, 2u, 4u, 7u, 16u, 19u, 1024u }) {
+      const auto a = random_words(rng, num_words);
+      const auto b = random_words(rng, num_words);
+      const auto c = random_words(rng, num_words);
+      std::vector<uint64_t> out(num_words);
+
+      kernels::not_words(out.data(), a.data(), num_words);
+      for (auto i = 0u; i < num_words; ++i) {
+        REQUIRE(out[i] == ~a[i]);
+      }
+
+      for (auto flags = 0u; flags < 8u; ++flags) {
+        kernels::and_words(out.data(), a.data(), b.data(), num_words, flags & 1u, flags & 2u, flags & 4u);
+        for (auto i = 0u; i < num_words; ++i) {
+          const auto x = (flags & 1u) ? ~a[i] : a[i];
+          const auto y = (flags & 2u) ? ~b[i] : b[i];
+          REQUIRE(out[i] == ((flags & 4u) ? ~(x & y) : (x & y)));
+        }
+      }
+
+      kernels::xor_words(out.data(), a.data(), b.data(), num_words, true);
+      for (auto i = 0u; i < num_words; ++i) {
+        REQUIRE(out[i] == ~(a[i] ^ b[i]));
+      }
+
+      kernels::maj_words(out.data(), a.data(), b.data(), c.data(), num_words, true, false, false, true);
+      for (auto i = 0u; i < num_words; ++i) {
+        REQUIRE(out[i] == ~((~a[i] & b[i]) | (~a[i] & c[i]) | (b[i] & c[i])));
+      }
+
+      for (auto function = 0u; function < 16u; ++function) {
+        kernels::binary_function_words(out.data(), a.data(), b.data(), num_words, function);
+        for (auto i = 0u; i < num_words; ++i) {
+          auto expected = uint64_t{ 0 };
+          for (auto bit = 0u; bit < 64u; ++bit) {
+            const auto minterm = ((a[i] >> bit) & 1u) | (((b[i] >> bit) & 1u) << 1u);
+            expected |= static_cast<uint64_t>((function >> minterm) & 1u) << bit;
+          }
+          REQUIRE(out[i] == expected);
+        }
+      }
+
+      // the output may be one of the inputs
+      auto in_place = a;
+      kernels::and_words(in_place.data(), in_place.data(), b.data(), num_words, false, true, false);
+      for (auto i = 0u; i < num_words; ++i) {
+        REQUIRE(in_place[i] == (a[i] & ~b[i]));
+      }
+    }
+  }
+
+  kernels::use_instruction_set(initial);
+}
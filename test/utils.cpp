@@ -0,0 +1,35 @@
+#include <enumeration_tool/utils.hpp>
+
+#include "catch2/catch.hpp"
+
+#include <kitty/constructors.hpp>
+#include <kitty/dynamic_truth_table.hpp>
+#include <kitty/operators.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+
+static_assert(projection_words(3, 0)[0] == 0xaa);
+static_assert(constant_words(2, true)[0] == 0xf);
+
+TEST_CASE( "precomputed terminal truth tables", "[utils]" )
+{
+  for (auto num_vars = 0u; num_vars <= max_terminal_vars; ++num_vars) {
+    kitty::dynamic_truth_table tt(num_vars);
+    REQUIRE(tt.num_blocks() == terminal_num_words(num_vars));
+    REQUIRE(std::equal(tt.cbegin(), tt.cend(), constant_words(num_vars, false)));
+    const auto one = ~tt;
+    REQUIRE(std::equal(one.cbegin(), one.cend(), constant_words(num_vars, true)));
+
+    for (auto var = 0u; var < num_vars; ++var) {
+      kitty::create_nth_var(tt, var);
+      REQUIRE(std::equal(tt.cbegin(), tt.cend(), projection_words(num_vars, var)));
+    }
+  }
+}
+
+TEST_CASE( "no precomputed truth tables above max_terminal_vars", "[utils]" )
+{
+  REQUIRE_THROWS_AS(constant_words(max_terminal_vars + 1, false), std::runtime_error);
+  REQUIRE_THROWS_AS(projection_words(max_terminal_vars + 1, 0), std::runtime_error);
+}